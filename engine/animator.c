@@ -1,12 +1,19 @@
 #include "animator.h"
 
+float animator_lod_pixels = 64.0f;
+int animator_lod_enabled = 1;
+
+int animator_evaluated;
+int animator_total;
+
 int animator_play(object* o, const char* name, int loop) {
   for (int i = 0; i < o->anim_count; i++) {
     if (strcmp(o->anims[i]->name, name) == 0) {
-      o->current_anim = o->anims[i];
-      o->current_anim->frame_time = 0;
-      o->current_anim->loop = loop;
-      o->current_anim->finished = 0;
+      o->playback.clip = o->anims[i];
+      o->playback.time = 0;
+      o->playback.loop = loop;
+      o->playback.finished = 0;
+      o->playback.pose_wait = 0;
       return 1;
     }
   }
@@ -16,23 +23,153 @@ int animator_play(object* o, const char* name, int loop) {
 }
 
 void animator_update(object* o, float dt) {
-  animation* a = o->current_anim;
+  animator_advance(o, dt);
+  animator_pose(o);
+}
+
+void animator_advance(object* o, float dt) {
+  animation_playback* p = &o->playback;
+  const animation* a = p->clip;
+  if (a == NULL || o->skel == NULL) {
+    return;
+  }
+
+  // only the object's cursor moves, the clip is shared
+  p->time += dt;
+  if (p->loop)
+    p->time = fmodf(p->time, a->frame_speed * (a->frame_count-1));
+  else
+    p->finished = (p->time / a->frame_speed) > (a->frame_count-1);
+}
+
+void animator_pose(object* o) {
+  const animation* a = o->playback.clip;
   skeleton* s = o->skel;
+  if (a == NULL || s == NULL) {
+    return;
+  }
+
+  animation_sample_to(a, o->playback.time, o->pose);
+
+  // model space and the inverse bind pose in the same pass
+  frame_gen_transforms(o->pose, s->rest_pose.transforms_inv);
+}
+
+// whether a sphere touches the clip space box of a view projection
+static int sphere_in_volume(const mat4 m, const vec3 center, float radius) {
+  for (int axis = 0; axis < 3; axis++) {
+    for (int side = -1; side <= 1; side += 2) {
+      // w + side * axis >= 0, from the rows of m
+      vec4 plane;
+      for (int i = 0; i < 4; i++) {
+        plane[i] = m[i][3] + side * m[i][axis];
+      }
+
+      float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+      if (distance < -radius * sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2])) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/* frames between two poses of o, 0 if no volume sees it. bounds are the
+   bind pose spheres of the meshes, placed where the object is now (attached
+   objects use their parent as it was last drawn) */
+static int pose_interval(const object* o, const animator_view* view) {
+  mat4 m;
+  object_get_transform(o, m);
+  if (o->parent != NULL) {
+    mat4 parent;
+    mat4_copy(parent, o->parent->world_transform);
+    if (o->parent_joint >= 0) {
+      mat4_mul(parent, parent, o->parent->pose->transforms[o->parent_joint]);
+    }
+    mat4_mul(m, parent, m);
+  }
+  float scale = vec3_len(m[0]);
 
-  animation_sample_to(a, dt, &s->current_frame);
+  int on_screen = 0;
+  int in_shadow = 0;
+  float size = 0.0f;
+  for (int i = 0; i < o->num_meshes; i++) {
+    mesh* mesh = &o->meshes[i];
+    vec4 center = { mesh->center[0], mesh->center[1], mesh->center[2], 1.0f };
+    vec4 world_center;
+    mat4_mul_vec4(world_center, m, center);
+    float radius = mesh->radius * scale;
 
-  frame* f = &s->current_frame;
-  frame_gen_transforms(f);
-  for (int i = 0; i < f->joint_count; i++) {
-    mat4_mul(f->transforms[i], f->transforms[i], s->rest_pose.transforms_inv[i]);
+    if (sphere_in_volume(view->camera, world_center, radius)) {
+      on_screen = 1;
+    }
+    for (int s = 0; s < view->shadow_count && !in_shadow; s++) {
+      in_shadow = sphere_in_volume(view->shadows[s], world_center, radius);
+    }
+
+    // radius in pixels, from the nearest point of the sphere
+    vec3 to_center;
+    vec3_sub(to_center, world_center, view->eye);
+    float distance = vec3_len(to_center) - radius;
+    if (distance < 0.1f) distance = 0.1f;
+    if (radius * view->pixels / distance > size) size = radius * view->pixels / distance;
+  }
+
+  if (!on_screen && !in_shadow) {
+    return 0;
+  }
+
+  int interval = 1;
+  while (interval < ANIMATOR_MAX_INTERVAL && size * interval < animator_lod_pixels) {
+    interval *= 2;
+  }
+  if (!on_screen && interval < ANIMATOR_MAX_INTERVAL) {
+    interval *= 2;
+  }
+  return interval;
+}
+
+void animator_schedule(object* objects[], int objects_length, const animator_view* view) {
+  animator_evaluated = 0;
+  animator_total = 0;
+
+  for (int i = 0; i < objects_length; i++) {
+    object* o = objects[i];
+    animation_playback* p = &o->playback;
+    if (p->clip == NULL || o->skel == NULL) {
+      continue;
+    }
+    animator_total++;
+
+    int interval = animator_lod_enabled ? pose_interval(o, view) : 1;
+    if (interval == 0) {
+      // held while hidden, due as soon as it is seen
+      p->pose_wait = 0;
+      continue;
+    }
+
+    // a rate that went up since the last pose applies right away
+    if (p->pose_wait > interval - 1) p->pose_wait = interval - 1;
+    if (p->pose_wait > 0) {
+      p->pose_wait--;
+      continue;
+    }
+
+    animator_pose(o);
+    p->pose_wait = interval - 1;
+    animator_evaluated++;
   }
 }
 
+const char* animator_current(object* o) {
+  return o->playback.clip != NULL ? o->playback.clip->name : "";
+}
+
 int animator_current_keyframe(object* o) {
-  animation* a = o->current_anim;
+  const animation* a = o->playback.clip;
 
   float curr_keyframe;
-  float curr_time = (a->frame_time / a->frame_speed);
+  float curr_time = (o->playback.time / a->frame_speed);
 
   curr_keyframe = curr_time < 0 ? 0 : curr_time;
   curr_keyframe = curr_keyframe > (a->frame_count-1) ? (a->frame_count-1) : curr_keyframe;
@@ -41,10 +178,10 @@ int animator_current_keyframe(object* o) {
 }
 
 int animator_total_keyframes(object* o) {
-  animation* a = o->current_anim;
+  const animation* a = o->playback.clip;
   return a->keyframe_count;
 }
 
 int animator_finished(object* o) {
-  return o->current_anim->finished;
+  return o->playback.finished;
 }
@@ -6,8 +6,43 @@
 #include "data/skeleton.h"
 #include "data/frame.h"
 
+#define ANIMATOR_MAX_SHADOWS 16
+#define ANIMATOR_MAX_INTERVAL 8
+
+/* where poses can be seen from in a frame: the camera and the volumes the
+   shadow maps are drawn for, each a view projection whose clip space box is
+   the volume */
+typedef struct {
+  vec3 eye;
+  float pixels;   // camera pixels per world unit, at distance 1
+  mat4 camera;
+  mat4 shadows[ANIMATOR_MAX_SHADOWS];
+  int shadow_count;
+} animator_view;
+
+// scheduled objects whose bounding sphere projects to fewer pixels than this
+// (radius) are posed every 2 frames, under half of it every 4 and so on
+extern float animator_lod_pixels;
+extern int animator_lod_enabled;
+
+// poses sampled by the last animator_schedule, out of the objects it was given
+extern int animator_evaluated;
+extern int animator_total;
+
 int animator_play(object* o, const char* name, int loop);
+// moves the clock and samples the pose
 void animator_update(object* o, float dt);
+// moves the clock only, the pose is held until it is sampled
+void animator_advance(object* o, float dt);
+// samples the pose at the clock
+void animator_pose(object* o);
+/* samples the poses of objects that are due this frame, after their clocks
+   moved. objects no view volume sees are not posed, the others every 1 to
+   ANIMATOR_MAX_INTERVAL frames by their size on screen (half that rate if
+   only shadows see them), holding the last pose in between */
+void animator_schedule(object* objects[], int objects_length, const animator_view* view);
+// name of the clip o is playing, "" if none
+const char* animator_current(object* o);
 int animator_current_keyframe(object* o);
 int animator_total_keyframes(object* o);
 int animator_finished(object* o);
@@ -0,0 +1,46 @@
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+
+// block data starts right after the (aligned) header
+#define BLOCK_HEADER ((sizeof(arena_block) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+void arena_init(arena* a, size_t block_size) {
+  a->head = NULL;
+  a->block_size = block_size;
+}
+
+void* arena_alloc(arena* a, size_t size) {
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+  arena_block* b = a->head;
+  if (b == NULL || b->used + size > b->size) {
+    // double the block size, or fit the request if it is bigger
+    size_t block_size = b != NULL ? b->size * 2 : a->block_size;
+    if (block_size < size) block_size = size;
+
+    b = malloc(BLOCK_HEADER + block_size);
+    if (b == NULL) {
+      printf("[arena] cannot allocate %zu bytes\n", block_size);
+      exit(1);
+    }
+    b->next = a->head;
+    b->size = block_size;
+    b->used = 0;
+    a->head = b;
+  }
+
+  void* p = (char*)b + BLOCK_HEADER + b->used;
+  b->used += size;
+  return p;
+}
+
+void arena_free(arena* a) {
+  arena_block* b = a->head;
+  while (b != NULL) {
+    arena_block* next = b->next;
+    free(b);
+    b = next;
+  }
+  a->head = NULL;
+}
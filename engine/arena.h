@@ -0,0 +1,22 @@
+#ifndef arena_h
+#define arena_h
+
+#include "engine.h"
+
+typedef struct arena_block {
+  struct arena_block* next;
+  size_t size;
+  size_t used;
+} arena_block;
+
+// bump allocator, blocks grow geometrically and are released all at once
+typedef struct {
+  arena_block* head;
+  size_t block_size;
+} arena;
+
+void arena_init(arena* a, size_t block_size);
+void* arena_alloc(arena* a, size_t size);
+void arena_free(arena* a);
+
+#endif
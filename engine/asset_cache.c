@@ -0,0 +1,79 @@
+#include "asset_cache.h"
+
+static asset_cache_entry entries[ASSET_CACHE_SIZE];
+
+static asset_cache_entry* find_entry(const char* asset) {
+  for (int i = 0; i < ASSET_CACHE_SIZE; i++) {
+    if (entries[i].asset != NULL && strcmp(entries[i].name, asset) == 0) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+
+static void free_entry(asset_cache_entry* e) {
+  renderer_free_object(e->asset);
+  object_free(e->asset);
+  free(e->asset);
+  e->asset = NULL;
+  e->refs = 0;
+}
+
+// takes ownership of an imported object and uploads it
+void asset_cache_add(const char* asset, object* o) {
+  if (find_entry(asset) != NULL) {
+    printf("[asset_cache] asset already cached: %s\n", asset);
+    exit(1);
+  }
+
+  for (int i = 0; i < ASSET_CACHE_SIZE; i++) {
+    asset_cache_entry* e = &entries[i];
+    if (e->asset == NULL) {
+      strcpy(e->name, asset);
+      e->asset = o;
+      e->refs = 0;
+      renderer_init_object(o);
+      return;
+    }
+  }
+
+  printf("[asset_cache] cache is full, cannot add %s\n", asset);
+  exit(1);
+}
+
+// new instance of the asset, imported on first use
+object* asset_cache_instance(const char* asset) {
+  asset_cache_entry* e = find_entry(asset);
+  if (e == NULL) {
+    asset_cache_add(asset, importer_load(asset));
+    e = find_entry(asset);
+  }
+
+  e->refs++;
+  return object_instance(e->asset);
+}
+
+// frees the instance, and the shared data once its last instance is gone
+void asset_cache_release(object* instance) {
+  for (int i = 0; i < ASSET_CACHE_SIZE; i++) {
+    asset_cache_entry* e = &entries[i];
+    if (e->asset != NULL && e->asset->meshes == instance->meshes) {
+      e->refs--;
+      if (e->refs == 0) {
+        free_entry(e);
+      }
+      break;
+    }
+  }
+
+  object_free(instance);
+  free(instance);
+}
+
+void asset_cache_free() {
+  for (int i = 0; i < ASSET_CACHE_SIZE; i++) {
+    if (entries[i].asset != NULL) {
+      free_entry(&entries[i]);
+    }
+  }
+}
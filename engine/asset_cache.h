@@ -0,0 +1,23 @@
+#ifndef asset_cache_h
+#define asset_cache_h
+
+#include "engine.h"
+#include "importer.h"
+#include "renderer.h"
+#include "data/object.h"
+
+#define ASSET_CACHE_SIZE 64
+
+// assets are imported and uploaded once, then shared by all their instances
+typedef struct {
+  char name[256];
+  object* asset;
+  int refs;
+} asset_cache_entry;
+
+object* asset_cache_instance(const char* asset);
+void asset_cache_add(const char* asset, object* o);
+void asset_cache_release(object* instance);
+void asset_cache_free();
+
+#endif
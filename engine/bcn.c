@@ -0,0 +1,229 @@
+#include "bcn.h"
+
+// weight of the first endpoint for each bc1 index
+static const float bc1_weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+// 4x4 block at (x, y), edge pixels repeat past the image
+static void fetch_block(const unsigned char* rgba, int width, int height, int x, int y, unsigned char block[16][4]) {
+  for (int j = 0; j < 4; j++) {
+    int py = y + j < height ? y + j : height - 1;
+    for (int i = 0; i < 4; i++) {
+      int px = x + i < width ? x + i : width - 1;
+      memcpy(block[j * 4 + i], rgba + ((size_t)py * width + px) * 4, 4);
+    }
+  }
+}
+
+static int clamp255(float v) {
+  return v < 0 ? 0 : v > 255 ? 255 : (int)(v + 0.5f);
+}
+
+static int pack565(const float c[3]) {
+  return (clamp255(c[0]) * 31 + 127) / 255 << 11 | (clamp255(c[1]) * 63 + 127) / 255 << 5 | (clamp255(c[2]) * 31 + 127) / 255;
+}
+
+static void unpack565(int c, int out[3]) {
+  int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+  out[0] = r << 3 | r >> 2;
+  out[1] = g << 2 | g >> 4;
+  out[2] = b << 3 | b >> 2;
+}
+
+// picks the nearest of the four colors for each pixel, returns the squared error
+static int fit_bc1(unsigned char block[16][4], int c0, int c1, int indices[16]) {
+  int e0[3], e1[3], palette[4][3];
+  unpack565(c0, e0);
+  unpack565(c1, e1);
+  for (int k = 0; k < 3; k++) {
+    palette[0][k] = e0[k];
+    palette[1][k] = e1[k];
+    palette[2][k] = (2 * e0[k] + e1[k]) / 3;
+    palette[3][k] = (e0[k] + 2 * e1[k]) / 3;
+  }
+
+  int error = 0;
+  for (int i = 0; i < 16; i++) {
+    int best = 0, best_error = INT_MAX;
+    for (int p = 0; p < 4; p++) {
+      int dr = block[i][0] - palette[p][0];
+      int dg = block[i][1] - palette[p][1];
+      int db = block[i][2] - palette[p][2];
+      int e = dr * dr + dg * dg + db * db;
+      if (e < best_error) {
+        best = p;
+        best_error = e;
+      }
+    }
+    indices[i] = best;
+    error += best_error;
+  }
+  return error;
+}
+
+// endpoints that best reproduce the block with the given indices (least squares)
+static int refit_bc1(unsigned char block[16][4], const int indices[16], int* c0, int* c1) {
+  float aa = 0, ab = 0, bb = 0, ax[3] = { 0 }, bx[3] = { 0 };
+  for (int i = 0; i < 16; i++) {
+    float a = bc1_weights[indices[i]], b = 1.0f - a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int k = 0; k < 3; k++) {
+      ax[k] += a * block[i][k];
+      bx[k] += b * block[i][k];
+    }
+  }
+
+  float det = aa * bb - ab * ab;
+  if (fabsf(det) < 1e-6f) {
+    return 0;
+  }
+
+  float e0[3], e1[3];
+  for (int k = 0; k < 3; k++) {
+    e0[k] = (bb * ax[k] - ab * bx[k]) / det;
+    e1[k] = (aa * bx[k] - ab * ax[k]) / det;
+  }
+  *c0 = pack565(e0);
+  *c1 = pack565(e1);
+  return 1;
+}
+
+static void compress_bc1(unsigned char block[16][4], unsigned char* out) {
+  // principal axis of the colors by power iteration on their covariance
+  float mean[3] = { 0 };
+  for (int i = 0; i < 16; i++) {
+    for (int k = 0; k < 3; k++) mean[k] += block[i][k] / 16.0f;
+  }
+
+  float cov[6] = { 0 };
+  for (int i = 0; i < 16; i++) {
+    float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+    cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+    cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+  }
+
+  float axis[3] = { 1, 1, 1 };
+  for (int it = 0; it < 4; it++) {
+    float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+    float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+    float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+    float len = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+    if (len < 1e-6f) break;
+    axis[0] = x / len;
+    axis[1] = y / len;
+    axis[2] = z / len;
+  }
+
+  // the extreme colors along it are the first guess
+  int lo = 0, hi = 0;
+  float lo_t = FLT_MAX, hi_t = -FLT_MAX;
+  for (int i = 0; i < 16; i++) {
+    float t = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+    if (t < lo_t) { lo_t = t; lo = i; }
+    if (t > hi_t) { hi_t = t; hi = i; }
+  }
+
+  float hi_c[3] = { block[hi][0], block[hi][1], block[hi][2] };
+  float lo_c[3] = { block[lo][0], block[lo][1], block[lo][2] };
+  int c0 = pack565(hi_c), c1 = pack565(lo_c);
+  int indices[16];
+  int error = fit_bc1(block, c0, c1, indices);
+
+  // then refine the endpoints while that helps
+  for (int it = 0; it < 2 && error > 0; it++) {
+    int r0, r1, refit[16];
+    if (!refit_bc1(block, indices, &r0, &r1)) break;
+    int e = fit_bc1(block, r0, r1, refit);
+    if (e >= error) break;
+    c0 = r0;
+    c1 = r1;
+    error = e;
+    memcpy(indices, refit, sizeof(indices));
+  }
+
+  // c0 > c1 selects the four color mode
+  if (c0 < c1) {
+    int t = c0;
+    c0 = c1;
+    c1 = t;
+    for (int i = 0; i < 16; i++) indices[i] ^= 1;
+  } else if (c0 == c1) {
+    for (int i = 0; i < 16; i++) indices[i] = 0;
+  }
+
+  unsigned bits = 0;
+  for (int i = 0; i < 16; i++) {
+    bits |= (unsigned)indices[i] << (2 * i);
+  }
+  out[0] = c0 & 255;
+  out[1] = c0 >> 8;
+  out[2] = c1 & 255;
+  out[3] = c1 >> 8;
+  memcpy(out + 4, &bits, 4);
+}
+
+// one channel between two endpoints with six interpolated values
+static void compress_bc4(unsigned char block[16][4], int channel, unsigned char* out) {
+  int hi = 0, lo = 255;
+  for (int i = 0; i < 16; i++) {
+    int v = block[i][channel];
+    if (v > hi) hi = v;
+    if (v < lo) lo = v;
+  }
+
+  int palette[8] = { hi, lo };
+  for (int p = 2; p < 8; p++) {
+    palette[p] = ((8 - p) * hi + (p - 1) * lo + 3) / 7;
+  }
+
+  unsigned long long bits = 0;
+  for (int i = 0; hi != lo && i < 16; i++) {
+    int v = block[i][channel];
+    int best = 0, best_error = INT_MAX;
+    for (int p = 0; p < 8; p++) {
+      int e = abs(v - palette[p]);
+      if (e < best_error) {
+        best = p;
+        best_error = e;
+      }
+    }
+    bits |= (unsigned long long)best << (3 * i);
+  }
+
+  out[0] = hi;
+  out[1] = lo;
+  for (int k = 0; k < 6; k++) {
+    out[2 + k] = bits >> (8 * k) & 255;
+  }
+}
+
+int bcn_size(bcn_format format, int width, int height) {
+  int blocks = ((width + 3) / 4) * ((height + 3) / 4);
+  return blocks * (format == BCN_BC1 ? 8 : 16);
+}
+
+void bcn_compress(bcn_format format, const unsigned char* rgba, int width, int height, unsigned char* out) {
+  unsigned char block[16][4];
+  for (int y = 0; y < height; y += 4) {
+    for (int x = 0; x < width; x += 4) {
+      fetch_block(rgba, width, height, x, y, block);
+      switch (format) {
+        case BCN_BC1:
+          compress_bc1(block, out);
+          out += 8;
+          break;
+        case BCN_BC3:
+          compress_bc4(block, 3, out);
+          compress_bc1(block, out + 8);
+          out += 16;
+          break;
+        case BCN_BC5:
+          compress_bc4(block, 0, out);
+          compress_bc4(block, 1, out + 8);
+          out += 16;
+          break;
+      }
+    }
+  }
+}
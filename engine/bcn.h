@@ -0,0 +1,19 @@
+#ifndef bcn_h
+#define bcn_h
+
+#include "engine.h"
+
+// s3tc/rgtc block compression, 4x4 pixel blocks
+typedef enum {
+  BCN_BC1 = 1,  // rgb, 8 bytes per block
+  BCN_BC3 = 3,  // rgba, 16 bytes per block
+  BCN_BC5 = 5   // two channels (normal map xy), 16 bytes per block
+} bcn_format;
+
+// bytes of a width x height image, partial blocks are padded
+int bcn_size(bcn_format format, int width, int height);
+
+// compresses rgba pixels (4 bytes each, rows top to bottom) into 'out'
+void bcn_compress(bcn_format format, const unsigned char* rgba, int width, int height, unsigned char* out);
+
+#endif
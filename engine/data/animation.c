@@ -1,58 +1,75 @@
 #include "animation.h"
+#include "../pose_kernels.h"
 
-animation* animation_create(const char* name) {
+animation* animation_create(const char* name, int joint_count) {
   
   animation* a = malloc(sizeof(animation));
   
   strcpy(a->name, name);
+  a->joint_count = joint_count;
+  a->stride = frame_lanes(joint_count);
   a->keyframe_count = 0;
+  a->keyframe_capacity = 0;
+  a->keyframes = NULL;
+  a->channels = NULL;
   a->frame_count = 0;
-  a->frame_time = 0;
   a->frame_speed = 1.0/30.0;
-  a->loop = 1;
-  a->finished = 0;
-  
-  for (int i = 0; i < MAX_KEYFRAMES; i++) {
-    a->frames[i].joint_count = 0;  
-  }
+  a->duration = 0;
 
   return a;
 }
 
 void animation_free(animation* a) {
+  free(a->keyframes);
+  free(a->channels);
   free(a);
 }
 
-void animation_add_keyframe(animation* a, float k) {
-  assert(a->keyframe_count < MAX_KEYFRAMES);
-  a->keyframes[a->keyframe_count++] = k; 
+void animation_add_keyframe(animation* a, float k, const frame* pose) {
+  if (a->keyframe_count == a->keyframe_capacity) {
+    a->keyframe_capacity = a->keyframe_capacity > 0 ? a->keyframe_capacity * 2 : 16;
+    a->keyframes = realloc(a->keyframes, a->keyframe_capacity * sizeof(float));
+    a->channels = realloc(a->channels, (size_t)a->keyframe_capacity * POSE_CHANNELS * a->stride * sizeof(float));
+    if (a->keyframes == NULL || a->channels == NULL) {
+      printf("[animation] out of memory for %s\n", a->name);
+      exit(1);
+    }
+  }
+
+  // padding lanes included, the pose has them at identity
+  float* keyframe = animation_keyframe(a, a->keyframe_count);
+  for (int c = 0; c < POSE_CHANNELS; c++) {
+    memcpy(&keyframe[c * a->stride], pose->joints[c], a->stride * sizeof(float));
+  }
+  a->keyframes[a->keyframe_count++] = k;
   a->duration = k;
 }
 
-static frame* animation_frame(animation* a, int i) {
+void animation_joint_set(animation* a, int keyframe, int joint_id, const vec3 position, const quat rotation) {
+  float* k = animation_keyframe(a, keyframe);
+  for (int c = 0; c < 3; c++) {
+    k[(POSE_X + c) * a->stride + joint_id] = position[c];
+  }
+  for (int c = 0; c < 4; c++) {
+    k[(POSE_QX + c) * a->stride + joint_id] = rotation[c];
+  }
+}
+
+static int animation_frame(const animation* a, int i) {
   i = i < 0 ? 0 : i;
   i = i > (a->frame_count-1) ? (a->frame_count-1) : i;
-  return &a->frames[i];
+  return i;
 }
 
-void animation_sample_to(animation* a, float dt, frame* out) {
+// samples the clip at 'time' seconds, clips are never modified so they can be shared
+void animation_sample_to(const animation* a, float time, frame* out) {
 
   assert(a->frame_count > 0);
 
-  if (a->frame_count == 1) {
-    frame_copy_to(&a->frames[0], out);
-  }
-
-  a->frame_time += dt;
-  if (a->loop)
-    a->frame_time = fmodf(a->frame_time, a->frame_speed * (a->frame_count-1));
-  else
-    a->finished = (a->frame_time / a->frame_speed) > (a->frame_count-1);
-
-  frame* frame0 = animation_frame(a, (a->frame_time / a->frame_speed) + 0);
-  frame* frame1 = animation_frame(a, (a->frame_time / a->frame_speed) + 1);
-  float amount = fmod(a->frame_time / a->frame_speed, 1.0);
+  int frame0 = animation_frame(a, (time / a->frame_speed) + 0);
+  int frame1 = animation_frame(a, (time / a->frame_speed) + 1);
+  float amount = a->frame_count == 1 ? 0.0f : fmod(time / a->frame_speed, 1.0);
 
-  frame_interpolate_to(frame0, frame1, amount, out);
+  pose_blend(out->joints[0], MAX_JOINTS, animation_keyframe(a, frame0), animation_keyframe(a, frame1), a->stride, amount, a->stride);
 
 }
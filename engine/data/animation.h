@@ -4,26 +4,51 @@
 #include "../engine.h"
 #include "frame.h"
 
-#define MAX_KEYFRAMES 512
-
+/* a clip only stores what sampling reads: the translation and rotation of
+   every joint at every keyframe. keyframes follow each other, each one laid
+   out like the joints of a frame (POSE_CHANNELS arrays) but with arrays of
+   stride floats, joint_count rounded up to POSE_LANES: channel c of joint j
+   in keyframe k is at (k * POSE_CHANNELS + c) * stride + j. the matrices
+   live in the poses it is sampled to */
 typedef struct {
   char name[256];
-  float keyframes[MAX_KEYFRAMES];
+  int joint_count;
+  int stride;
   int keyframe_count;
-  frame frames[MAX_KEYFRAMES];
+  int keyframe_capacity;
+  float* keyframes;
+  float* channels;
   int frame_count;
-  float frame_time;
   float frame_speed;
   int duration;
+} animation;
+
+/* where one object is in a clip. clips are shared and never written while
+   playing, every object playing one keeps its own cursor, moved by the
+   animator */
+typedef struct {
+  const animation* clip;
+  float time;
   int loop;
   int finished;
-} animation;
 
-animation* animation_create(const char* name);
+  // frames until the animator samples the pose again, 0 when it is due (a
+  // new clip is posed on its first update)
+  int pose_wait;
+} animation_playback;
+
+animation* animation_create(const char* name, int joint_count);
 void animation_free(animation* a);
 
-void animation_add_keyframe(animation* a, float k);
+// appends a keyframe at time k, starting from the joints of pose
+void animation_add_keyframe(animation* a, float k, const frame* pose);
+void animation_joint_set(animation* a, int keyframe, int joint_id, const vec3 position, const quat rotation);
+
+// first float of a keyframe
+static inline float* animation_keyframe(const animation* a, int keyframe) {
+  return a->channels + (size_t)keyframe * POSE_CHANNELS * a->stride;
+}
 
-void animation_sample_to(animation* a, float dt, frame* out);
+void animation_sample_to(const animation* a, float time, frame* out);
 
 #endif
@@ -1,17 +1,31 @@
 #include "frame.h"
+#include "../pose_kernels.h"
 
 frame* frame_create() {
   frame* f = malloc(sizeof(frame));
-  f->joint_count = 0;
+  frame_clear(f);
   return f;
 }
 
+void frame_clear(frame* f) {
+  f->joint_count = 0;
+  for (int c = 0; c < POSE_CHANNELS; c++) {
+    float value = c == POSE_QW ? 1.0f : 0.0f;
+    for (int i = 0; i < MAX_JOINTS; i++) {
+      f->joints[c][i] = value;
+    }
+  }
+}
+
 frame* frame_copy(frame* f) {
   
   frame* fn = frame_create();
   
   for (int i = 0; i < f->joint_count; i++) {
-    frame_joint_add(fn, i, f->joint_parents[i], f->joint_positions[i], f->joint_rotations[i]);
+    vec3 position;
+    quat rotation;
+    frame_joint_get(f, i, position, rotation);
+    frame_joint_add(fn, i, f->joint_parents[i], position, rotation);
   }
   
   return fn;
@@ -27,90 +41,69 @@ frame* frame_interpolate(frame* f0, frame* f1, float amount) {
 }
 
 void frame_interpolate_to(frame* f0, frame* f1, float amount, frame* out) {
-  
-  for (int i = 0; i < out->joint_count; i++) {
-    vec3_lerp(out->joint_positions[i], f0->joint_positions[i], f1->joint_positions[i], amount);
-    quat_slerp(out->joint_rotations[i], f0->joint_rotations[i], f1->joint_rotations[i], amount);
-  }
-  
+  pose_blend(out->joints[0], MAX_JOINTS, f0->joints[0], f1->joints[0], MAX_JOINTS, amount, frame_lanes(out->joint_count));
 }
 
 void frame_copy_to(frame* f, frame* out) {
   memcpy(out, f, sizeof(frame));
 }
 
-static bool frame_descendant_of(frame* f, int decendent, int joint) {
-  
-  if (f->joint_parents[decendent] == joint) { return true;  }
-  if (f->joint_parents[decendent] == -1)    { return false; }
-  return frame_descendant_of(f, f->joint_parents[decendent], joint);
-  
-}
-
 void frame_descendants_to(frame* f0, frame* f1, float amount, int joint, frame* out) {
 
+  frame_interpolate_to(f0, f1, amount, out);
+
+  // parents come first, so a joint is in the subtree once its parent is.
+  // the others keep f0
+  bool inside[MAX_JOINTS];
   for (int i = 0; i < out->joint_count; i++) {
-    if (frame_descendant_of(out, i, joint) || (joint == i)) {
-      vec3_lerp(out->joint_positions[i], f0->joint_positions[i], f1->joint_positions[i], amount);
-      quat_slerp(out->joint_rotations[i], f0->joint_rotations[i], f1->joint_rotations[i], amount);
-    } else {
-      vec3_lerp(out->joint_positions[i], f0->joint_positions[i], f1->joint_positions[i], 0.0);
-      quat_slerp(out->joint_rotations[i], f0->joint_rotations[i], f1->joint_rotations[i], 0.0);
+    int parent = out->joint_parents[i];
+    inside[i] = (joint == i) || (parent >= 0 && inside[parent]);
+    if (!inside[i]) {
+      for (int c = 0; c < POSE_CHANNELS; c++) {
+        out->joints[c][i] = f0->joints[c][i];
+      }
     }
   }
 
 }
 
-void frame_joint_transform(mat4 ret, frame* f, int i) {
-  
-  if (f->joint_transforms_computed[i]) {
-    mat4_copy(ret, f->joint_transforms[i]);
-    return;
-  }
-
-  mat4 rot;
-  mat4_identity(ret);
-
-  if (f->joint_parents[i] != -1) {
-    mat4 prev;
-    frame_joint_transform(prev, f, f->joint_parents[i]);
-    mat4_mul(ret, ret, prev);
-  }  
-
-  mat4 t;
-  mat4_translate(t, f->joint_positions[i][0], f->joint_positions[i][1], f->joint_positions[i][2]);
-
-  mat4_from_quat(rot, f->joint_rotations[i]);
-  mat4_mul(ret, ret, t);
-  mat4_mul(ret, ret, rot);
-  mat4_copy(f->joint_transforms[i], ret);
-  f->joint_transforms_computed[i] = 1;
-
-}
-
 void frame_joint_add(frame* f, int joint_id, int parent, vec3 position, quat rotation) {
   
   f->joint_count++;
   assert(f->joint_count < MAX_JOINTS);
 
   f->joint_parents[joint_id] = parent;
-  vec3_copy(f->joint_positions[joint_id], position);
-  vec3_copy(f->joint_rotations[joint_id], rotation);
+  frame_joint_set(f, joint_id, position, rotation);
   mat4_identity(f->transforms[joint_id]);
   mat4_identity(f->transforms_inv[joint_id]);
 
 }
 
-void frame_gen_transforms(frame* f) {
-  
-  for (int i = 0; i < f->joint_count; i++) {
-    f->joint_transforms_computed[i] = 0;
+void frame_joint_get(const frame* f, int joint_id, vec3 position, quat rotation) {
+  for (int c = 0; c < 3; c++) {
+    position[c] = f->joints[POSE_X + c][joint_id];
+  }
+  for (int c = 0; c < 4; c++) {
+    rotation[c] = f->joints[POSE_QX + c][joint_id];
   }
+}
 
-  for (int i = 0; i < f->joint_count; i++) {
-    frame_joint_transform(f->transforms[i], f, i);
+void frame_joint_set(frame* f, int joint_id, const vec3 position, const quat rotation) {
+  for (int c = 0; c < 3; c++) {
+    f->joints[POSE_X + c][joint_id] = position[c];
+  }
+  for (int c = 0; c < 4; c++) {
+    f->joints[POSE_QX + c][joint_id] = rotation[c];
   }
-  
+}
+
+void frame_gen_transforms(frame* f, const mat4* inv_bind) {
+
+  // rotations for all joints at once, then the parent chain one by one
+  float rot[9][MAX_JOINTS];
+  pose_rotations(rot, f);
+  pose_chain(f, rot, inv_bind);
+
 }
 
 void frame_gen_inv_transforms(frame* f) {
@@ -120,4 +113,3 @@ void frame_gen_inv_transforms(frame* f) {
   }
 
 }
-
@@ -5,28 +5,52 @@
 
 #define MAX_JOINTS 128
 
+// joints the widest pose kernel works on at once, joint channels are padded
+// to a multiple of it (with identity joints)
+#define POSE_LANES 8
+
+/* a joint's translation and rotation relative to its parent are kept one
+   channel per array (x[], y[], z[], qx[] .. qw[]) so the pose kernels load
+   consecutive joints at once. clips store their keyframes the same way */
+enum {
+  POSE_X, POSE_Y, POSE_Z,
+  POSE_QX, POSE_QY, POSE_QZ, POSE_QW,
+  POSE_CHANNELS
+};
+
+/* joints come before their children (see skeleton_sort). joint_transforms
+   are model space, transforms what the shaders get: model space times the
+   inverse bind pose when there is one */
 typedef struct {
   int joint_count;
   int joint_parents[MAX_JOINTS];
-  vec3 joint_positions[MAX_JOINTS];
-  quat joint_rotations[MAX_JOINTS];
+  float joints[POSE_CHANNELS][MAX_JOINTS];
   mat4 joint_transforms[MAX_JOINTS];
-  int joint_transforms_computed[MAX_JOINTS];
   mat4 transforms[MAX_JOINTS];
   mat4 transforms_inv[MAX_JOINTS];
 } frame;
 
+// joint_count rounded up to POSE_LANES
+static inline int frame_lanes(int joint_count) {
+  return (joint_count + POSE_LANES - 1) / POSE_LANES * POSE_LANES;
+}
+
 frame* frame_create();
+// no joints, every lane set to the identity
+void frame_clear(frame* f);
 frame* frame_copy(frame* f);
 frame* frame_interpolate(frame* f0, frame* f1, float amount);
 void frame_copy_to(frame* f, frame* out);
 void frame_interpolate_to(frame* f0, frame* f1, float amount, frame* out);
 void frame_descendants_to(frame* f0, frame* f1, float amount, int joint, frame* out);
 
-void frame_joint_transform(mat4 ret, frame* f, int i);
 void frame_joint_add(frame* f, int joint_id, int parent, vec3 position, quat rotation);
+void frame_joint_get(const frame* f, int joint_id, vec3 position, quat rotation);
+void frame_joint_set(frame* f, int joint_id, const vec3 position, const quat rotation);
 
-void frame_gen_transforms(frame* f);
+// one pass over the joints in order, inv_bind NULL for transforms to be the
+// model space ones
+void frame_gen_transforms(frame* f, const mat4* inv_bind);
 void frame_gen_inv_transforms(frame* f);
 
 #endif
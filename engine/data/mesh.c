@@ -1,60 +1,170 @@
 #include "mesh.h"
 
+typedef struct {
+  mesh* m;
+  GLuint first, last;   // vertices this worker owns
+} tangent_job;
+
+/* accumulates the uv aligned direction of every triangle (weighted by its
+   size, lengyel 2001) into the corners the job owns, then makes each of
+   them perpendicular to its normal. the tangents are the sums until then,
+   so nothing is allocated, and jobs never write the same vertex */
+static void* tangent_worker(void* arg) {
+  tangent_job* job = arg;
+  mesh* m = job->m;
+  vertex* vertices = m->vertices;
+  const GLuint* indices = m->indices;
+
+  for (GLuint v = job->first; v < job->last; v++) {
+    vertices[v].tx = vertices[v].ty = vertices[v].tz = 0.0f;
+  }
+
+  for (GLuint i = 0; i + 2 < m->num_indices; i += 3) {
+    GLuint a = indices[i], b = indices[i + 1], c = indices[i + 2];
+    int owns_a = a >= job->first && a < job->last;
+    int owns_b = b >= job->first && b < job->last;
+    int owns_c = c >= job->first && c < job->last;
+    if (!owns_a && !owns_b && !owns_c) continue;
+
+    const vertex* v1 = &vertices[a];
+    const vertex* v2 = &vertices[b];
+    const vertex* v3 = &vertices[c];
+    float e1x = v2->x - v1->x, e1y = v2->y - v1->y, e1z = v2->z - v1->z;
+    float e2x = v3->x - v1->x, e2y = v3->y - v1->y, e2z = v3->z - v1->z;
+    float du1 = v2->u - v1->u, dv1 = v2->v - v1->v;
+    float du2 = v3->u - v1->u, dv2 = v3->v - v1->v;
+
+    // no uv area, no direction
+    float det = du1 * dv2 - du2 * dv1;
+    if (fabsf(det) < 1e-12f) continue;
+
+    float f = 1.0f / det;
+    float tx = f * (dv2 * e1x - dv1 * e2x);
+    float ty = f * (dv2 * e1y - dv1 * e2y);
+    float tz = f * (dv2 * e1z - dv1 * e2z);
+
+    if (owns_a) { vertices[a].tx += tx; vertices[a].ty += ty; vertices[a].tz += tz; }
+    if (owns_b) { vertices[b].tx += tx; vertices[b].ty += ty; vertices[b].tz += tz; }
+    if (owns_c) { vertices[c].tx += tx; vertices[c].ty += ty; vertices[c].tz += tz; }
+  }
+
+  // gram-schmidt against the normal, any perpendicular when nothing is left
+  for (GLuint v = job->first; v < job->last; v++) {
+    vertex* p = &vertices[v];
+    vec3 n = { p->nx, p->ny, p->nz };
+    vec3 t = { p->tx, p->ty, p->tz };
+    vec3 projected;
+    vec3_scale(projected, n, vec3_mul_inner(n, t));
+    vec3_sub(t, t, projected);
+
+    float length = vec3_len(t);
+    if (!(length > 1e-12f)) {
+      vec3 axis = { 1.0f, 0.0f, 0.0f };
+      if (fabsf(n[0]) > 0.9f) {
+        axis[0] = 0.0f;
+        axis[1] = 1.0f;
+      }
+      vec3_mul_cross(t, axis, n);
+      length = vec3_len(t);
+      if (!(length > 1e-12f)) {
+        t[0] = 1.0f;
+        t[1] = t[2] = 0.0f;
+        length = 1.0f;
+      }
+    }
+
+    p->tx = t[0] / length;
+    p->ty = t[1] / length;
+    p->tz = t[2] / length;
+  }
+
+  return NULL;
+}
+
 void mesh_compute_tangent(mesh* m) {
-  for (unsigned int i = 0; i < m->num_indices; i += 3) {
-    vertex v1, v2, v3;
-    v1 = m->vertices[m->indices[i]];
-    v2 = m->vertices[m->indices[i + 1]];
-    v3 = m->vertices[m->indices[i + 2]];
-
-    vec2 uv1 = { v1.u, v1.v };
-    vec2 uv2 = { v2.u, v2.v };
-    vec2 uv3 = { v3.u, v3.v };
-
-    vec3 v1_pos = { v1.x, v1.y, v1.z };
-    vec3 v2_pos = { v2.x, v2.y, v2.z };
-    vec3 v3_pos = { v3.x, v3.y, v3.z };
-
-    vec3 edge1;
-    vec3 edge2;
-    vec3_sub(edge1, v2_pos, v1_pos);
-    vec3_sub(edge2, v3_pos, v1_pos);
-
-    vec2 delta_uv1;
-    vec2 delta_uv2;
-    vec2_sub(delta_uv1, uv2, uv1);
-    vec2_sub(delta_uv2, uv3, uv1);
-
-    GLfloat f = 1.0f / (delta_uv1[0] * delta_uv2[1] - delta_uv2[0] * delta_uv1[1]);
-
-    vec3 tangent;
-    tangent[0] = f * (delta_uv2[1] * edge1[0] - delta_uv1[1] * edge2[0]);
-    tangent[1] = f * (delta_uv2[1] * edge1[1] - delta_uv1[1] * edge2[1]);
-    tangent[2] = f * (delta_uv2[1] * edge1[2] - delta_uv1[1] * edge2[2]);
-    vec3_norm(tangent, tangent);
-
-    v1.tx = tangent[0];
-    v1.ty = tangent[1];
-    v1.tz = tangent[2];
-    v2.tx = tangent[0];
-    v2.ty = tangent[1];
-    v2.tz = tangent[2];
-    v3.tx = tangent[0];
-    v3.ty = tangent[1];
-    v3.tz = tangent[2];
-
-    m->vertices[m->indices[i]] = v1;
-    m->vertices[m->indices[i + 1]] = v2;
-    m->vertices[m->indices[i + 2]] = v3;
-  }
-
-  // normalize
-  for (unsigned int i = 0; i < m->num_indices; i++) {
-    vertex v = m->vertices[m->indices[i]];
-    vec3 tnorm = { v.tx, v.ty, v.tz };
-    vec3_norm(tnorm, tnorm);
-    m->vertices[m->indices[i]].tx = tnorm[0];
-    m->vertices[m->indices[i]].ty = tnorm[1];
-    m->vertices[m->indices[i]].tz = tnorm[2];
+  // each worker reads every index, so only big meshes are split
+  long threads = m->num_indices / 3 / MESH_TANGENT_MIN_TRIANGLES;
+  if (threads > 1) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > cpus) threads = cpus;
+  }
+  if (threads > MESH_MAX_THREADS) threads = MESH_MAX_THREADS;
+  if (threads < 1) threads = 1;
+
+  tangent_job jobs[MESH_MAX_THREADS];
+  pthread_t workers[MESH_MAX_THREADS];
+  for (int i = 0; i < threads; i++) {
+    jobs[i].m = m;
+    jobs[i].first = (GLuint)((unsigned long long)m->num_vertices * i / threads);
+    jobs[i].last = (GLuint)((unsigned long long)m->num_vertices * (i + 1) / threads);
+  }
+
+  for (int i = 1; i < threads; i++) {
+    if (pthread_create(&workers[i], NULL, tangent_worker, &jobs[i]) != 0) {
+      printf("[mesh] cannot create tangent thread\n");
+      exit(1);
+    }
+  }
+
+  // first range is handled by the calling thread
+  tangent_worker(&jobs[0]);
+
+  for (int i = 1; i < threads; i++) {
+    pthread_join(workers[i], NULL);
+  }
+}
+
+void mesh_compute_bounds(mesh* m) {
+  vec3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+  vec3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  float area = 0.0f, uv_area = 0.0f;
+
+  for (unsigned int i = 0; i + 2 < m->num_indices; i += 3) {
+    vertex* v[3] = { &m->vertices[m->indices[i]], &m->vertices[m->indices[i + 1]], &m->vertices[m->indices[i + 2]] };
+
+    for (int k = 0; k < 3; k++) {
+      vec3 p = { v[k]->x, v[k]->y, v[k]->z };
+      for (int c = 0; c < 3; c++) {
+        min[c] = fminf(min[c], p[c]);
+        max[c] = fmaxf(max[c], p[c]);
+      }
+    }
+
+    vec3 edge1 = { v[1]->x - v[0]->x, v[1]->y - v[0]->y, v[1]->z - v[0]->z };
+    vec3 edge2 = { v[2]->x - v[0]->x, v[2]->y - v[0]->y, v[2]->z - v[0]->z };
+    vec3 cross;
+    vec3_mul_cross(cross, edge1, edge2);
+    area += vec3_len(cross);
+    uv_area += fabsf((v[1]->u - v[0]->u) * (v[2]->v - v[0]->v) - (v[2]->u - v[0]->u) * (v[1]->v - v[0]->v));
+  }
+
+  if (m->num_indices < 3) {
+    vec3_zero(m->center);
+    m->radius = 0.0f;
+    m->uv_density = 0.0f;
+    return;
+  }
+
+  vec3_add(m->center, min, max);
+  vec3_scale(m->center, m->center, 0.5f);
+  vec3 extent;
+  vec3_sub(extent, max, m->center);
+  m->radius = vec3_len(extent);
+
+  // both areas are doubled, the ratio of their roots is a length ratio
+  m->uv_density = area > 0.0f ? sqrtf(uv_area / area) : 0.0f;
+}
+
+void mesh_init_lods(mesh* m) {
+  m->num_lods = 1;
+  m->lod_indices[0] = m->num_indices;
+  m->lod_error[0] = 0.0f;
+}
+
+GLuint mesh_total_indices(const mesh* m) {
+  GLuint total = 0;
+  for (int i = 0; i < m->num_lods; i++) {
+    total += m->lod_indices[i];
   }
+  return total;
 }
@@ -5,6 +5,13 @@
 #include "vertex.h"
 #include "material.h"
 
+#define MESH_MAX_LODS 4
+
+// tangents are generated on up to this many threads, each with at least
+// this many triangles
+#define MESH_MAX_THREADS 16
+#define MESH_TANGENT_MIN_TRIANGLES 16384
+
 typedef struct {
   char name[256];
 
@@ -14,15 +21,44 @@ typedef struct {
   GLuint num_indices;
   GLuint num_vertices;
 
-  GLuint vao, vbo, ebo;
+  // detail levels: level 0 is the whole mesh (num_indices), coarser ones
+  // follow it in the index range and use the same vertices. lod_error is
+  // how far, in object units, a level may be off the whole mesh
+  int num_lods;
+  GLuint lod_indices[MESH_MAX_LODS];
+  float lod_error[MESH_MAX_LODS];
+
+  // every mesh of an object draws from one vertex array, vertex and index
+  // buffer: its indices start at first_index and count from base_vertex.
+  // skin_vbo holds the joints of skinned objects, 0 for static ones
+  GLuint vao, vbo, skin_vbo, ebo;
+  GLenum index_type;
+  GLuint first_index;
+  GLint base_vertex;
+
   material mat;
 
   GLuint texture_id;
   GLuint normal_map_id;
   GLuint specular_map_id;
   GLuint mask_map_id;
+
+  // object space bounding sphere, and texture coordinate units per object
+  // unit for picking the mip levels to stream
+  vec3 center;
+  float radius;
+  float uv_density;
 } mesh;
 
+// per vertex tangents, summed over the triangles around each vertex and
+// made perpendicular to its normal
 void mesh_compute_tangent(mesh* m);
+void mesh_compute_bounds(mesh* m);
+
+// a single level, the whole mesh
+void mesh_init_lods(mesh* m);
+
+// indices of every level
+GLuint mesh_total_indices(const mesh* m);
 
 #endif
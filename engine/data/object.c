@@ -31,8 +31,38 @@ object* object_create(vec3 position, GLfloat scale, mesh* meshes, int num_meshes
 
   // skeleton
   obj->skel = s;
+  obj->pose = NULL;
+  if (s != NULL) {
+    obj->pose = malloc(sizeof(frame));
+    frame_copy_to(&s->rest_pose, obj->pose);
+  }
 
   obj->anim_count = 0;
+  obj->playback.clip = NULL;
+  obj->playback.time = 0;
+  obj->playback.loop = 1;
+  obj->playback.finished = 0;
+  obj->playback.pose_wait = 0;
+
+  obj->owns_data = 1;
+  obj->mapping.data = NULL;
+  obj->mapping.size = 0;
+  memset(&obj->streams, 0, sizeof(obj->streams));
+
+  return obj;
+}
+
+// new object sharing the meshes, skeleton and clips of o
+object* object_instance(const object* o) {
+  object* obj = (object*)malloc(sizeof(object));
+  memcpy(obj, o, sizeof(object));
+
+  if (o->pose != NULL) {
+    obj->pose = malloc(sizeof(frame));
+    frame_copy_to(o->pose, obj->pose);
+  }
+
+  obj->owns_data = 0;
 
   return obj;
 }
@@ -42,7 +72,7 @@ void object_add_animation(object* o, animation* a) {
   o->anims[o->anim_count] = a;
 
   if (o->anim_count == 0) {
-    o->current_anim = a;
+    o->playback.clip = a;
   }
 
   o->anim_count++;
@@ -132,19 +162,28 @@ void object_set_position(object* o, vec3 pos) {
 }
 
 void object_free(object* o) {
+  free(o->pose);
+  o->pose = NULL;
+
+  if (!o->owns_data) {
+    return;
+  }
+
   if (o->meshes != NULL) {
-    if (o->num_meshes > 0) {
-      for (int i = 0; i < o->num_meshes; i++) {
-        free(o->meshes[i].vertices);
-      }
+    for (int i = 0; i < o->num_meshes && o->mapping.data == NULL; i++) {
+      // imported meshes are consecutive ranges of the same vertex and index buffers
+      if (i > 0 && o->meshes[i].vertices == o->meshes[i - 1].vertices + o->meshes[i - 1].num_vertices) continue;
+      free(o->meshes[i].vertices);
+      free(o->meshes[i].indices);
     }
     free(o->meshes);
     o->meshes = NULL;
   }
 
+  vfs_close(&o->mapping);
+
   if (o->skel != NULL) {
     skeleton_free(o->skel);
-    free(o->skel);
     o->skel = NULL;
   }
 
@@ -9,6 +9,17 @@
 
 #define OBJECT_MAX_ANIMS 16
 
+/* what the gpu reads for every mesh of a baked object, in the mapping: the
+   packed vertices, their skin (skinned objects only) and the indices, 16
+   bit or 32 bit as index_type says. packed is NULL when the renderer has to
+   pack the meshes itself */
+typedef struct {
+  const vertex_packed* packed;
+  const vertex_skin* skin;
+  const void* indices;
+  GLenum index_type;
+} object_streams;
+
 struct object {
   // parent
   struct object* parent;
@@ -40,16 +51,25 @@ struct object {
   // audio
   ALuint audio_source;
 
-  // animations
+  // animations (skeleton and clips can be shared, pose is per object)
   skeleton* skel;
+  frame* pose;
   animation* anims[OBJECT_MAX_ANIMS];
   int anim_count;
-  animation* current_anim;
+  animation_playback playback;
+
+  // meshes, skeleton and clips are freed with the object
+  int owns_data;
+
+  // baked file the meshes point into (data is NULL if they were allocated)
+  vfs_file mapping;
+  object_streams streams;
 };
 
 typedef struct object object;
 
 object* object_create(vec3 position, GLfloat scale, mesh* meshes, int num_meshes, int compute_center, skeleton* s);
+object* object_instance(const object* o);
 void object_add_animation(object* o, animation* a);
 void object_get_transform(const object* o, mat4 m);
 void object_get_center(const object* o, vec3* out_center);
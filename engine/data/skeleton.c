@@ -5,8 +5,7 @@ skeleton* skeleton_create() {
   skeleton* s = malloc(sizeof(skeleton));
   s->joint_count = 0;
   // s->joint_names = NULL;
-  s->rest_pose.joint_count = 0;  
-  s->current_frame.joint_count = 0;  
+  frame_clear(&s->rest_pose);
 
   return s;
   
@@ -23,19 +22,11 @@ void skeleton_joint_add(skeleton* s, int joint_id, char* name, int parent, mat4
 
   strcpy(&s->joint_names[joint_id], name);
   
-  vec3 zero;
-  vec3_zero(zero);
-
-  quat q;
-  quat_identity(q);
-  frame_joint_add(&s->rest_pose, joint_id, parent, zero, q);
-
-  // set rotation
-  quat_from_mat4(s->rest_pose.joint_rotations[joint_id], transform);
-
-  // set position
+  // rotation and position
+  quat rotation;
+  quat_from_mat4(rotation, transform);
   vec3 position = { transform[3][0], transform[3][1], transform[3][2] };
-  vec3_copy(s->rest_pose.joint_positions[joint_id], position);
+  frame_joint_add(&s->rest_pose, joint_id, parent, position, rotation);
 
   // set inverse position
   mat4_invert(s->rest_pose.transforms_inv[joint_id], transform);
@@ -52,3 +43,78 @@ int skeleton_joint_id(skeleton* s, char* name) {
   return -1;
   
 }
+
+int skeleton_sort(skeleton* s, int* remap) {
+
+  frame* f = &s->rest_pose;
+  int n = f->joint_count;
+
+  int sorted = 1;
+  for (int i = 0; i < n; i++) {
+    int parent = f->joint_parents[i];
+    if (parent < -1 || parent >= n) {
+      printf("[skeleton] joint %d has no parent %d\n", i, parent);
+      exit(1);
+    }
+    sorted = sorted && parent < i;
+    remap[i] = i;
+  }
+  if (sorted) {
+    return 0;
+  }
+
+  // children of every joint in id order, slot 0 holds the roots
+  int first_child[MAX_JOINTS + 2] = { 0 };
+  int children[MAX_JOINTS];
+  for (int i = 0; i < n; i++) {
+    first_child[f->joint_parents[i] + 2]++;
+  }
+  for (int i = 0; i <= n; i++) {
+    first_child[i + 1] += first_child[i];
+  }
+  int fill[MAX_JOINTS + 2];
+  memcpy(fill, first_child, sizeof(fill));
+  for (int i = 0; i < n; i++) {
+    children[fill[f->joint_parents[i] + 1]++] = i;
+  }
+
+  /* depth first from the roots with an explicit stack, children pushed backwards to come out in order */
+  int order[MAX_JOINTS];
+  int stack[MAX_JOINTS];
+  int count = 0, top = 0;
+  for (int c = first_child[1] - 1; c >= first_child[0]; c--) {
+    stack[top++] = children[c];
+  }
+  while (top > 0) {
+    int joint = stack[--top];
+    order[count++] = joint;
+    for (int c = first_child[joint + 2] - 1; c >= first_child[joint + 1]; c--) {
+      stack[top++] = children[c];
+    }
+  }
+
+  // joints never reached hang off a cycle
+  if (count != n) {
+    printf("[skeleton] joint parents form a cycle\n");
+    exit(1);
+  }
+
+  for (int i = 0; i < n; i++) {
+    remap[order[i]] = i;
+  }
+
+  frame old;
+  memcpy(old.joint_parents, f->joint_parents, n * sizeof(int));
+  memcpy(old.joints, f->joints, sizeof(f->joints));
+  memcpy(old.transforms_inv, f->transforms_inv, n * sizeof(mat4));
+  for (int i = 0; i < n; i++) {
+    int j = order[i];
+    f->joint_parents[i] = old.joint_parents[j] >= 0 ? remap[old.joint_parents[j]] : -1;
+    for (int c = 0; c < POSE_CHANNELS; c++) {
+      f->joints[c][i] = old.joints[c][j];
+    }
+    mat4_copy(f->transforms_inv[i], old.transforms_inv[j]);
+  }
+
+  return 1;
+}
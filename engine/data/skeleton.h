@@ -8,7 +8,6 @@ typedef struct {
   int joint_count;
   char joint_names[256];
   frame rest_pose;
-  frame current_frame;
 } skeleton;
 
 skeleton* skeleton_create();
@@ -16,4 +15,9 @@ void skeleton_free(skeleton* s);
 void skeleton_joint_add(skeleton* s, int joint_id, char* name, int parent, mat4 transform);
 int skeleton_joint_id(skeleton* s, char* name);
 
+/* renumbers the joints so every parent comes before its children (depth
+   first, siblings keep their order), which frame_gen_transforms relies on.
+   remap[old id] is the new id, 0 when the joints were already in order */
+int skeleton_sort(skeleton* s, int* remap);
+
 #endif
@@ -0,0 +1,70 @@
+#include "vertex.h"
+
+// round to nearest, flushes what is below the normal range of a half to zero
+static GLhalf to_half(float f) {
+  unsigned int bits;
+  memcpy(&bits, &f, sizeof(bits));
+
+  unsigned int sign = (bits >> 16) & 0x8000;
+  int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+  unsigned int mantissa = bits & 0x7fffff;
+
+  if (((bits >> 23) & 0xff) == 0xff) {
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  }
+  if (exponent <= 0) {
+    return sign;
+  }
+
+  // carry of the rounding can move into the exponent, which is what we want
+  unsigned int h = ((unsigned int)exponent << 10) | (mantissa >> 13);
+  h += (mantissa >> 12) & 1;
+  if (h >= 0x7c00) {
+    h = 0x7c00;
+  }
+  return sign | h;
+}
+
+static GLuint snorm10(float c) {
+  if (c != c) c = 0.0f;
+  if (c < -1.0f) c = -1.0f;
+  if (c > 1.0f) c = 1.0f;
+  return (GLuint)lroundf(c * 511.0f) & 0x3ff;
+}
+
+static GLuint pack_2_10_10_10(float x, float y, float z) {
+  return snorm10(x) | (snorm10(y) << 10) | (snorm10(z) << 20);
+}
+
+void vertex_pack(const vertex* v, vertex_packed* out) {
+  out->x = v->x;
+  out->y = v->y;
+  out->z = v->z;
+  out->u = to_half(v->u);
+  out->v = to_half(v->v);
+  out->normal = pack_2_10_10_10(v->nx, v->ny, v->nz);
+  out->tangent = pack_2_10_10_10(v->tx, v->ty, v->tz);
+}
+
+void vertex_pack_skin(const vertex* v, vertex_skin* out) {
+  float joints[3] = { v->jx, v->jy, v->jz };
+  float weights[3] = { v->wx, v->wy, v->wz };
+
+  int sum = 0, largest = 0;
+  for (int i = 0; i < 3; i++) {
+    out->joints[i] = (GLubyte)fminf(fmaxf(joints[i], 0.0f), 255.0f);
+    out->weights[i] = (GLubyte)lroundf(fminf(fmaxf(weights[i], 0.0f), 1.0f) * 255.0f);
+    sum += out->weights[i];
+    if (weights[i] > weights[largest]) largest = i;
+  }
+  out->joints[3] = 0;
+  out->weights[3] = 0;
+
+  // rounding must not scale the blended transform: the largest weight
+  // takes up what the three lost or gained
+  int total = (int)lroundf(fminf(fmaxf(weights[0] + weights[1] + weights[2], 0.0f), 1.0f) * 255.0f);
+  int fixed = out->weights[largest] + total - sum;
+  if (fixed >= 0 && fixed <= 255) {
+    out->weights[largest] = (GLubyte)fixed;
+  }
+}
@@ -23,4 +23,21 @@ typedef struct {
   GLfloat wz;
 } vertex;
 
+/* what the gpu reads: every mesh gets a base stream, skinned objects a
+   second one with the joints (static meshes never fetch it) */
+typedef struct {
+  GLfloat x, y, z;
+  GLhalf u, v;
+  GLuint normal;   // signed normalized 10-10-10-2
+  GLuint tangent;
+} vertex_packed;
+
+typedef struct {
+  GLubyte joints[4];
+  GLubyte weights[4]; // normalized, as much of 255 as the float weights were of 1
+} vertex_skin;
+
+void vertex_pack(const vertex* v, vertex_packed* out);
+void vertex_pack_skin(const vertex* v, vertex_skin* out);
+
 #endif
@@ -41,16 +41,24 @@ void dict_insert(dict* h, const char key[256], void* value) {
   h->values[i] = value;
   h->size++;
 
-  // resize
-  if (h->size >= h->capacity) {
-    int new_capacity = (int)(h->capacity * 1.5f);
-    h->keys = realloc(h->keys, new_capacity * sizeof(char*));
-    h->values = realloc(h->values, new_capacity * sizeof(void*));
-    for (int i = h->capacity; i < new_capacity; i++) {
-      h->keys[i] = NULL; 
-      h->values[i] = NULL;
+  // resize (keys are rehashed, their slot depends on the capacity)
+  if (h->size * 2 >= h->capacity) {
+    int old_capacity = h->capacity;
+    char** old_keys = h->keys;
+    void** old_values = h->values;
+
+    h->capacity = old_capacity * 2;
+    h->keys = calloc(h->capacity, sizeof(char*));
+    h->values = calloc(h->capacity, sizeof(void*));
+    for (int i = 0; i < old_capacity; i++) {
+      if (old_keys[i] != NULL) {
+        int j = dict_index(h, old_keys[i]);
+        h->keys[j] = old_keys[i];
+        h->values[j] = old_values[i];
+      }
     }
-    h->capacity = new_capacity;
+    free(old_keys);
+    free(old_values);
   }
 }
 
@@ -5,12 +5,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <time.h>
 #include <glad/glad.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
 #include <stdbool.h>
 #include <math.h>
+#include <float.h>
+#include <ctype.h>
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <AL/alut.h>
@@ -24,6 +27,7 @@
 #include <unistd.h>
 #include <assert.h>
 #include <dirent.h>
+#include <pthread.h>
 
 /* math */
 #include "linmath.h"
@@ -33,5 +37,15 @@
 
 /* include data structures */
 #include "dict.h"
+#include "vertex_table.h"
+#include "arena.h"
+
+/* file system */
+#include "lz4.h"
+#include "vfs.h"
+
+/* textures */
+#include "bcn.h"
+#include "stex.h"
 
 #endif
@@ -79,6 +79,7 @@ object* factory_create_sphere(float radius, int sector_count, int stack_count) {
   m->num_vertices = vcount;
   m->indices = indices;
   m->num_indices = icount;
+  mesh_init_lods(m);
 
   object* obj = object_create(NULL, 1.0f, m, 1, 1, NULL);
   return obj;
@@ -108,6 +109,7 @@ object* factory_create_plane(float width, float height) {
   m->num_vertices = 4;
   m->indices = indices;
   m->num_indices = 6;
+  mesh_init_lods(m);
 
   object* obj = object_create(NULL, 1.0f, m, 1, 1, NULL);
   return obj;
@@ -238,6 +240,7 @@ object* factory_create_box(float width, float height, float depth) {
 
   m->vertices = vertices;
   m->indices = indices;
+  mesh_init_lods(m);
 
   object* obj = object_create(NULL, 1.0f, m, 1, 1, NULL);
   return obj;
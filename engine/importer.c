@@ -1,27 +1,19 @@
 #include "importer.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
 
-const int INIT_SIZE = 256 * 10000;
 const char* TEXTURES_PATH = "/textures/";
 const char* ASSETS_PATH = "assets/";
 
-static vec3* temp_vertices;
-static vec2* temp_uvs;
-static vec3* temp_normals;
-static GLuint* indices;
+// obj files are split in chunks of at least this size, one per thread
+#define MIN_CHUNK_SIZE (64 * 1024)
 
-static dict* vh;
-static dict* materials;
+// first block of the per-load arena holding temporary buffers
+#define ARENA_BLOCK_SIZE (64 * 1024)
 
-static int vsize, vcount;
-static int vtsize, vtcount;
-static int vnsize, vncount;
-static int isize, icount;
-
-static int total_vertices_size, total_vertices;
-static vertex* vertices;
-
-static int meshes_size, meshes_count;
-static mesh* meshes;
+int importer_threads = 0;
+int importer_legacy = 0;
+int importer_baked = 1;
 
 typedef struct {
   int joint_ids[3];
@@ -29,16 +21,355 @@ typedef struct {
   int count;
 } vertex_weights;
 
-static int has_skl_file;
-static vertex_weights* vweights;
+// parse state of one load
+struct importer_ctx {
+  // temporary buffers, released at once at the end of the load
+  arena load_arena;
+
+  vec3* temp_vertices;
+  vec2* temp_uvs;
+  vec3* temp_normals;
+  GLuint* indices;
+
+  vertex_table* vh;
+  dict* materials;
+
+  int vcount, vtcount, vncount, icount;
+
+  int total_vertices;
+  vertex* vertices;
+
+  // where the mesh being filled starts in the vertex and index buffers
+  int first_vertex, first_index;
+
+  int meshes_count;
+  mesh* meshes;
+
+  int has_skl_file;
+  vertex_weights* vweights;
+  int weight_count;
+  // joint ids of the skl file to sorted ones
+  int joint_remap[MAX_JOINTS];
+
+  animation* animations[OBJECT_MAX_ANIMS];
+  int animation_count;
+};
+
+/* tokenizer (works directly on the mapped file, which is not null terminated) */
+static inline int is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skip_spaces(const char* p, const char* end) {
+  while (p < end && is_space(*p)) p++;
+  return p;
+}
+
+static inline const char* skip_line(const char* p, const char* end) {
+  const char* nl = memchr(p, '\n', end - p);
+  return nl ? nl + 1 : end;
+}
+
+static inline const char* skip_word(const char* p, const char* end) {
+  while (p < end && !is_space(*p) && *p != '\n') p++;
+  return p;
+}
+
+// true if the line starting at p begins with the token 'word'
+static int token_is(const char* p, const char* end, const char* word) {
+  while (*word) {
+    if (p >= end || *p != *word) return 0;
+    p++; word++;
+  }
+  return p == end || is_space(*p) || *p == '\n';
+}
+
+// copy the next whitespace separated token into out
+static const char* parse_word(const char* p, const char* end, char* out, int out_size) {
+  p = skip_spaces(p, end);
+  const char* start = p;
+  p = skip_word(p, end);
+
+  int len = p - start;
+  if (len >= out_size) len = out_size - 1;
+  memcpy(out, start, len);
+  out[len] = '\0';
+  return p;
+}
+
+static const char* parse_int(const char* p, const char* end, int* out) {
+  int sign = 1;
+  if (p < end && (*p == '-' || *p == '+')) {
+    if (*p == '-') sign = -1;
+    p++;
+  }
+
+  int value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+
+  *out = sign * value;
+  return p;
+}
+
+static const double POW10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+  1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const char* parse_float(const char* p, const char* end, float* out) {
+  p = skip_spaces(p, end);
+  const char* start = p;
+
+  int negative = 0;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+
+  // accumulate all digits into one integer mantissa
+  unsigned long long mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    mantissa = mantissa * 10 + (*p - '0');
+    digits++;
+    p++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits++;
+      exponent--;
+      p++;
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    int e;
+    p = parse_int(p + 1, end, &e);
+    exponent += e;
+  }
+
+  // fast path: mantissa and power of ten are both exact doubles
+  if (digits > 0 && digits <= 15 && exponent >= -22 && exponent <= 22) {
+    double value = (double)mantissa;
+    value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+    *out = negative ? -(float)value : (float)value;
+    return p;
+  }
+
+  // slow path for unusual numbers (nan, inf, long mantissas)
+  char buf[64];
+  const char* word_end = skip_word(start, end);
+  int len = word_end - start < 63 ? word_end - start : 63;
+  memcpy(buf, start, len);
+  buf[len] = '\0';
+  *out = strtof(buf, NULL);
+  return word_end;
+}
+
+/* chunked obj parsing: every thread parses the records of a slice of the
+   file into its own arrays, the slices are then merged in file order */
+typedef struct {
+  int v, vt, vn; // 1-based, 0 when missing
+} face_corner;
+
+// parse a v, v/vt, v//vn or v/vt/vn face corner
+static const char* parse_corner(const char* p, const char* end, face_corner* out) {
+  out->vt = out->vn = 0;
+  p = parse_int(p, end, &out->v);
+  if (p < end && *p == '/') {
+    p++;
+    if (p < end && *p != '/') p = parse_int(p, end, &out->vt);
+    if (p < end && *p == '/') p = parse_int(p + 1, end, &out->vn);
+  }
+  return skip_word(p, end);
+}
+
+enum { MARKER_MTLLIB, MARKER_USEMTL };
+
+typedef struct {
+  int type;
+  int face; // faces of the file preceding the marker
+  char name[256];
+} obj_marker;
+
+// every chunk is scanned twice: once to count its records, then again to
+// parse them into its slice of the load-wide arrays
+typedef struct {
+  const char* begin;
+  const char* end;
+
+  int positions_count;
+  int uvs_count;
+  int normals_count;
+  int faces_count;
+  int markers_count;
+  int usemtl_count;
+
+  vec3* positions;
+  vec2* uvs;
+  vec3* normals;
+  face_corner* corners;
+  obj_marker* markers;
+  int face_offset;
+} obj_chunk;
+
+enum { RECORD_NONE, RECORD_V, RECORD_VT, RECORD_VN, RECORD_F, RECORD_MTLLIB, RECORD_USEMTL };
+
+static int record_type(const char* line, const char* end) {
+  switch (line[0]) {
+    case 'v':
+      if (is_space(line[1])) return RECORD_V;
+      if (line[1] == 't' && is_space(line[2])) return RECORD_VT;
+      if (line[1] == 'n' && is_space(line[2])) return RECORD_VN;
+      break;
+    case 'f':
+      if (is_space(line[1])) return RECORD_F;
+      break;
+    case 'm':
+      if (token_is(line, end, "mtllib")) return RECORD_MTLLIB;
+      break;
+    case 'u':
+      if (token_is(line, end, "usemtl")) return RECORD_USEMTL;
+      break;
+  }
+  return RECORD_NONE;
+}
+
+static void* count_chunk(void* arg) {
+  obj_chunk* c = arg;
+  const char* p = c->begin;
+  const char* end = c->end;
+
+  while (p < end) {
+    p = skip_spaces(p, end);
+    if (end - p < 3) break;
+
+    switch (record_type(p, end)) {
+      case RECORD_V: c->positions_count++; break;
+      case RECORD_VT: c->uvs_count++; break;
+      case RECORD_VN: c->normals_count++; break;
+      case RECORD_F: c->faces_count++; break;
+      case RECORD_MTLLIB: c->markers_count++; break;
+      case RECORD_USEMTL: c->markers_count++; c->usemtl_count++; break;
+    }
+
+    p = skip_line(p, end);
+  }
+
+  return NULL;
+}
+
+static void* parse_chunk(void* arg) {
+  obj_chunk* c = arg;
+  const char* p = c->begin;
+  const char* end = c->end;
+
+  vec3* position = c->positions;
+  vec2* uv = c->uvs;
+  vec3* normal = c->normals;
+  face_corner* corner = c->corners;
+  obj_marker* marker = c->markers;
+
+  while (p < end) {
+    p = skip_spaces(p, end);
+    if (end - p < 3) break;
+    const char* line = p;
+    const char* q;
+    int type = record_type(line, end);
+
+    switch (type) {
+      case RECORD_V:
+        // new vertex
+        q = parse_float(line + 1, end, &(*position)[0]);
+        q = parse_float(q, end, &(*position)[1]);
+        parse_float(q, end, &(*position)[2]);
+        position++;
+        break;
+      case RECORD_VT:
+        // new texcoords
+        q = parse_float(line + 2, end, &(*uv)[0]);
+        parse_float(q, end, &(*uv)[1]);
+        uv++;
+        break;
+      case RECORD_VN:
+        // new normal
+        q = parse_float(line + 2, end, &(*normal)[0]);
+        q = parse_float(q, end, &(*normal)[1]);
+        parse_float(q, end, &(*normal)[2]);
+        normal++;
+        break;
+      case RECORD_F:
+        // new face (first three corners)
+        q = line + 1;
+        for (int i = 0; i < 3; i++) {
+          q = skip_spaces(q, end);
+          q = parse_corner(q, end, corner++);
+        }
+        break;
+      case RECORD_MTLLIB:
+      case RECORD_USEMTL:
+        // load mtl / use mtl
+        marker->type = type == RECORD_MTLLIB ? MARKER_MTLLIB : MARKER_USEMTL;
+        marker->face = c->face_offset + (corner - c->corners) / 3;
+        parse_word(line + 6, end, marker->name, sizeof(marker->name));
+        marker++;
+        break;
+    }
+
+    p = skip_line(p, end);
+  }
+
+  return NULL;
+}
+
+static int split_chunks(const vfs_file* file, obj_chunk* chunks) {
+  int threads = importer_threads > 0 ? importer_threads : sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads > IMPORTER_MAX_THREADS) threads = IMPORTER_MAX_THREADS;
+  if (threads < 1) threads = 1;
+
+  int count = file->size / MIN_CHUNK_SIZE;
+  if (count > threads) count = threads;
+  if (count < 1) count = 1;
+
+  // cut at line boundaries
+  const char* end = file->data + file->size;
+  const char* p = file->data;
+  for (int i = 0; i < count; i++) {
+    memset(&chunks[i], 0, sizeof(obj_chunk));
+    chunks[i].begin = p;
+    if (i == count - 1) {
+      p = end;
+    } else {
+      p = skip_line(file->data + file->size * (i + 1) / count, end);
+      if (p < chunks[i].begin) p = chunks[i].begin;
+    }
+    chunks[i].end = p;
+  }
+
+  return count;
+}
+
+static void run_chunks(obj_chunk* chunks, int count, void* (*worker)(void*)) {
+  pthread_t threads[IMPORTER_MAX_THREADS];
 
-static animation* animations[OBJECT_MAX_ANIMS];
-static int animation_count = 0;
+  for (int i = 1; i < count; i++) {
+    if (pthread_create(&threads[i], NULL, worker, &chunks[i]) != 0) {
+      printf("[importer] cannot create parser thread\n");
+      exit(1);
+    }
+  }
+
+  // first chunk is handled by the calling thread
+  worker(&chunks[0]);
 
-static const char* get_filename_ext(const char* filename) {
-  const char* dot = strrchr(filename, '.');
-  if(!dot || dot == filename) return "";
-  return dot + 1;
+  for (int i = 1; i < count; i++) {
+    pthread_join(threads[i], NULL);
+  }
 }
 
 static int find_file_ext(const char* asset, const char* ext, char* out_path) {
@@ -47,30 +378,35 @@ static int find_file_ext(const char* asset, const char* ext, char* out_path) {
   strcat(dir, asset);
   strcat(dir, "/");
 
-  struct dirent *de;  // Pointer for directory entry 
-  DIR* dr = opendir(dir); 
+  char names[OBJECT_MAX_ANIMS][256];
+  if (vfs_list(dir, ext, names, OBJECT_MAX_ANIMS) == 0) {
+    return 0;
+  }
 
-  if (dr == NULL) { 
-    printf("[find_file_ext] Could not open directory: %s\n", dir); 
-    return 0; 
-  } 
+  if (out_path != NULL) {
+    strcpy(out_path, dir);
+    strcat(out_path, names[0]);
+  }
+  return 1;
+}
 
-  while ((de = readdir(dr)) != NULL) {
-    if (strcmp(ext, get_filename_ext(de->d_name)) == 0) {
-      if (out_path != NULL) {
-        strcpy(out_path, dir);
-        strcat(out_path, de->d_name);
-      }
-      closedir(dr);     
-      return 1;
-    }
+// copies the next line of the file into 'line' (like fgets)
+static int next_line(const char** p, const char* end, char* line, int size) {
+  if (*p >= end) {
+    return 0;
   }
 
-  closedir(dr);     
-  return 0; 
+  const char* nl = memchr(*p, '\n', end - *p);
+  const char* line_end = nl ? nl + 1 : end;
+  int len = line_end - *p;
+  if (len >= size) len = size - 1;
+  memcpy(line, *p, len);
+  line[len] = '\0';
+  *p = line_end;
+  return 1;
 }
 
-static skeleton* import_skl(const char* asset) {
+static skeleton* import_skl(importer_ctx* ctx, const char* asset) {
   // find asset/asset.skl
   char skl_path[256];
   if (!find_file_ext(asset, "skl", skl_path)) {
@@ -80,20 +416,22 @@ static skeleton* import_skl(const char* asset) {
 
   printf("[importer] found %s\n", skl_path);
 
-  FILE* file = fopen(skl_path, "r");
-  if (file == NULL) {
+  vfs_file file;
+  if (!vfs_open(skl_path, &file)) {
     printf("[importer] cannot find file: %s\n", skl_path);
     exit(1);
   }
 
   char line[256];
+  const char* p = file.data;
+  const char* end = file.data + file.size;
 
   skeleton* skl = skeleton_create();
 
   // 0 = none, 1 = joints, 2 = joints_inv, 3 = weights
   int state = 0;
    
-  while (fgets(line, sizeof(line), file)) {
+  while (next_line(&p, end, line, sizeof(line))) {
     if (strstr(line, "joints") != NULL) {
       state = 1;
     } else if (strstr(line, "bindpose_inv") != NULL) {
@@ -103,10 +441,11 @@ static skeleton* import_skl(const char* asset) {
 
       int weights_size = 0;
       sscanf(line, "weights %d", &weights_size);
+      ctx->weight_count = weights_size;
 
-      vweights = malloc(weights_size * sizeof(vertex_weights));
+      ctx->vweights = arena_alloc(&ctx->load_arena, weights_size * sizeof(vertex_weights));
       for (int i = 0; i < weights_size; i++) {
-        vweights[i].count = 0;
+        ctx->vweights[i].count = 0;
       }
     } else {
       if (state == 1) { // joints
@@ -140,7 +479,7 @@ static skeleton* import_skl(const char* asset) {
         float weight;
         sscanf(line, "%d %d %f", &vertex_id, &joint_id, &weight);
 
-        vertex_weights* vw = &vweights[vertex_id];
+        vertex_weights* vw = &ctx->vweights[vertex_id];
         vw->joint_ids[vw->count] = joint_id;
         vw->weights[vw->count] = weight;
         vw->count++;
@@ -148,32 +487,42 @@ static skeleton* import_skl(const char* asset) {
     }
   }
 
+  // parents first, the weights follow the joints they point to
+  if (skeleton_sort(skl, ctx->joint_remap)) {
+    for (int i = 0; i < ctx->weight_count; i++) {
+      vertex_weights* vw = &ctx->vweights[i];
+      for (int j = 0; j < vw->count; j++) {
+        vw->joint_ids[j] = ctx->joint_remap[vw->joint_ids[j]];
+      }
+    }
+  }
+
   // compute world transform
-  frame_gen_transforms(&skl->rest_pose);
+  frame_gen_transforms(&skl->rest_pose, NULL);
 
-  // copy rest pose to current frame
-  frame_copy_to(&skl->rest_pose, &skl->current_frame);
-  
-  fclose(file);
+  vfs_close(&file);
   return skl;
 }
 
-static animation* import_anm(const char* anim_path, const char* anim_name, skeleton* s) {
+// remap turns the joint ids of the file into the ones of the sorted skeleton
+static animation* import_anm(const char* anim_path, const char* anim_name, skeleton* s, const int* remap) {
   // find asset/asset.anm
-  FILE* file = fopen(anim_path, "r");
-  if (file == NULL) {
+  vfs_file file;
+  if (!vfs_open(anim_path, &file)) {
     printf("[importer] cannot find file: %s\n", anim_path);
     exit(1);
   }
 
   char line[256];
+  const char* p = file.data;
+  const char* end = file.data + file.size;
 
-  animation* anm = animation_create(anim_name);
+  animation* anm = animation_create(anim_name, s->joint_count);
 
   // 0 = none, 1 = keyframes, 2 = animations
   int state = 0;
   int keyframe_id = 0;
-  while (fgets(line, sizeof(line), file)) {
+  while (next_line(&p, end, line, sizeof(line))) {
     if (strstr(line, "keyframes") != NULL) {
       state = 1;
     } else if (strstr(line, "time") != NULL) {
@@ -187,8 +536,8 @@ static animation* import_anm(const char* anim_path, const char* anim_name, skele
       if (state == 1) {
         float time;
         sscanf(line, "%f", &time);
-        animation_add_keyframe(anm, time);
-        frame_copy_to(&s->rest_pose, &anm->frames[keyframe_id]);
+        // joints the keyframe does not list keep their rest pose
+        animation_add_keyframe(anm, time, &s->rest_pose);
         keyframe_id++;
       } else if (state == 2) {
 
@@ -202,53 +551,307 @@ static animation* import_anm(const char* anim_path, const char* anim_name, skele
             &t[0][2], &t[1][2], &t[2][2], &t[3][2],
             &t[0][3], &t[1][3], &t[2][3], &t[3][3]);
 
-        // set rotation
-        quat_from_mat4(anm->frames[keyframe_id].joint_rotations[joint_id], t);
-
-        // set position
+        if (keyframe_id < 0 || keyframe_id >= anm->keyframe_count || joint_id < 0 || joint_id >= anm->joint_count) {
+          continue;
+        }
+        // set rotation and position
+        quat rotation;
+        quat_from_mat4(rotation, t);
         vec3 position = { t[3][0], t[3][1], t[3][2] };
-        vec3_copy(anm->frames[keyframe_id].joint_positions[joint_id], position);
+        animation_joint_set(anm, keyframe_id, remap[joint_id], position, rotation);
 
       }
     }
   }
 
-  fclose(file);
+  vfs_close(&file);
   return anm;
 }
 
-static void import_animations(const char* asset, skeleton* s) {
+static void import_animations(importer_ctx* ctx, const char* asset, skeleton* s) {
   char dir[256];
   strcpy(dir, ASSETS_PATH);
   strcat(dir, asset);
   strcat(dir, "/");
 
-  struct dirent *de;  // Pointer for directory entry 
-  DIR* dr = opendir(dir); 
+  char names[OBJECT_MAX_ANIMS][256];
+  int count = vfs_list(dir, "anm", names, OBJECT_MAX_ANIMS);
+
+  char anim[512];
+  for (int i = 0; i < count; i++) {
+    printf("[importer] found %s\n", names[i]);
+    strcpy(anim, dir);
+    strcat(anim, names[i]);
+    // clip name is the file name without extension
+    char name[256];
+    strcpy(name, names[i]);
+    *strrchr(name, '.') = '\0';
+    ctx->animations[ctx->animation_count] = import_anm(anim, name, s, ctx->joint_remap);
+    ctx->animation_count++;
+  }
+}
 
-  if (dr == NULL) { 
-    printf("[find_file_ext] Could not open directory: %s\n", dir); 
-    return;
-  } 
+static void import_mtl(importer_ctx* ctx, const char* asset) {
+  // find asset/asset.mtl
+  char mtl_path[256];
+  if (!find_file_ext(asset, "mtl", mtl_path)) {
+    printf("[importer] cannot find mtl file\n");
+    exit(1);
+  }
+
+  printf("[importer] found %s\n", mtl_path);
+
+  vfs_file file;
+  if (!vfs_open(mtl_path, &file)) {
+    printf("[importer] cannot find file: %s\n", mtl_path);
+    exit(1);
+  }
 
-  char anim[256];
+  char tex_path[256];
+  strcpy(tex_path, ASSETS_PATH);
+  strcat(tex_path, asset);
+  strcat(tex_path, TEXTURES_PATH);
 
-  int i = 0;
-  while ((de = readdir(dr)) != NULL) {
-    if (strcmp("anm", get_filename_ext(de->d_name)) == 0) {
-      printf("[importer] found %s\n", de->d_name);
-      strcpy(anim, dir);
-      strcat(anim, de->d_name);
-      animations[animation_count] = import_anm(anim, strtok(de->d_name, "."), s);
-      animation_count++;
+  material* current_mat = NULL;
+  const char* p = file.data;
+  const char* end = file.data + file.size;
+  while (p < end) {
+    p = skip_spaces(p, end);
+    if (end - p < 3) break;
+    const char* line = p;
+    char* map_path = NULL;
+
+    switch (line[0]) {
+      case 'n':
+        // new material
+        if (token_is(line, end, "newmtl")) {
+          if (current_mat != NULL) {
+            dict_insert(ctx->materials, current_mat->name, current_mat);
+          }
+          current_mat = (material*)malloc(sizeof(material));
+          material_init(current_mat);
+          parse_word(line + 6, end, current_mat->name, sizeof(current_mat->name));
+        }
+        break;
+      case 'm':
+        // texture maps: assets/[asset]/textures/[map].png
+        if (current_mat == NULL) break;
+        if (token_is(line, end, "map_Kd")) {
+          map_path = current_mat->texture_path;
+        } else if (token_is(line, end, "map_Kn")) {
+          map_path = current_mat->normal_map_path;
+        } else if (token_is(line, end, "map_Ks")) {
+          map_path = current_mat->specular_map_path;
+        } else if (token_is(line, end, "map_d")) {
+          map_path = current_mat->mask_map_path;
+        }
+
+        if (map_path != NULL) {
+          char name[256];
+          parse_word(skip_word(line, end), end, name, sizeof(name));
+          strcpy(map_path, tex_path);
+          strcat(map_path, name);
+        }
+        break;
+      case 'K':
+        if (current_mat == NULL) break;
+        // diffuse
+        if (token_is(line, end, "Kd")) {
+          const char* q = parse_float(line + 2, end, &current_mat->diffuse[0]);
+          q = parse_float(q, end, &current_mat->diffuse[1]);
+          parse_float(q, end, &current_mat->diffuse[2]);
+        }
+        // specular
+        else if (token_is(line, end, "Ks")) {
+          parse_float(line + 2, end, &current_mat->specular);
+        }
+        break;
+      case 'r':
+        if (current_mat != NULL && token_is(line, end, "r")) {
+          parse_float(line + 1, end, &current_mat->reflectivity);
+        }
+        break;
     }
+
+    p = skip_line(p, end);
+  }
+
+  if (current_mat != NULL) {
+    dict_insert(ctx->materials, current_mat->name, current_mat);
   }
 
-  closedir(dr);     
+  vfs_close(&file);
 }
 
-static void import_mtl(const char* asset) {
-  // find asset/asset.mtl
+// appends the vertex of a face corner
+static void push_vertex(importer_ctx* ctx, const face_corner* fc) {
+  // get vertex indices (vertex, texcoords, normals)
+  int v_index = fc->v - 1;
+  int vt_index = fc->vt - 1;
+  int vn_index = fc->vn - 1;
+
+  // push vertex
+  vertex* out = &ctx->vertices[ctx->total_vertices];
+  out->x = ctx->temp_vertices[v_index][0];
+  out->y = ctx->temp_vertices[v_index][1];
+  out->z = ctx->temp_vertices[v_index][2];
+  out->u = vt_index >= 0 ? ctx->temp_uvs[vt_index][0] : 0.0f;
+  out->v = vt_index >= 0 ? ctx->temp_uvs[vt_index][1] : 0.0f;
+  out->nx = vn_index >= 0 ? ctx->temp_normals[vn_index][0] : 0.0f;
+  out->ny = vn_index >= 0 ? ctx->temp_normals[vn_index][1] : 0.0f;
+  out->nz = vn_index >= 0 ? ctx->temp_normals[vn_index][2] : 0.0f;
+
+  if (ctx->has_skl_file) {
+    out->jx = ctx->vweights[v_index].joint_ids[0];
+    out->jy = ctx->vweights[v_index].joint_ids[1];
+    out->jz = ctx->vweights[v_index].joint_ids[2];
+    out->wx = ctx->vweights[v_index].weights[0];
+    out->wy = ctx->vweights[v_index].weights[1];
+    out->wz = ctx->vweights[v_index].weights[2];
+  } else {
+    out->jx = out->jy = out->jz = 0.0f;
+    out->wx = out->wy = out->wz = 0.0f;
+  }
+
+  ctx->total_vertices++;
+}
+
+static void push_index(importer_ctx* ctx, const face_corner* fc) {
+  // get index from hashtable (or insert it if not present)
+  int found = vertex_table_insert(ctx->vh, fc->v, fc->vt, fc->vn, ctx->total_vertices);
+  ctx->indices[ctx->icount] = found - ctx->first_vertex;
+
+  if (found == ctx->total_vertices) {
+    push_vertex(ctx, fc);
+  }
+  ctx->icount++;
+}
+
+// size every buffer from the record counts of the first pass and hand
+// each chunk its slice of the temporary arrays
+static void init_structures(importer_ctx* ctx, obj_chunk* chunks, int count) {
+  int faces = 0, markers = 0, meshes_size = 0;
+  ctx->vcount = ctx->vtcount = ctx->vncount = 0;
+
+  for (int i = 0; i < count; i++) {
+    chunks[i].face_offset = faces;
+    ctx->vcount += chunks[i].positions_count;
+    ctx->vtcount += chunks[i].uvs_count;
+    ctx->vncount += chunks[i].normals_count;
+    faces += chunks[i].faces_count;
+    markers += chunks[i].markers_count;
+    meshes_size += chunks[i].usemtl_count;
+  }
+
+  ctx->temp_vertices = arena_alloc(&ctx->load_arena, ctx->vcount * sizeof(vec3));
+  ctx->temp_uvs = arena_alloc(&ctx->load_arena, ctx->vtcount * sizeof(vec2));
+  ctx->temp_normals = arena_alloc(&ctx->load_arena, ctx->vncount * sizeof(vec3));
+  face_corner* corners = arena_alloc(&ctx->load_arena, faces * 3 * sizeof(face_corner));
+  obj_marker* marker_list = arena_alloc(&ctx->load_arena, markers * sizeof(obj_marker));
+
+  int v = 0, vt = 0, vn = 0, m = 0;
+  for (int i = 0; i < count; i++) {
+    obj_chunk* c = &chunks[i];
+    c->positions = ctx->temp_vertices + v;
+    c->uvs = ctx->temp_uvs + vt;
+    c->normals = ctx->temp_normals + vn;
+    c->corners = corners + c->face_offset * 3;
+    c->markers = marker_list + m;
+    v += c->positions_count;
+    vt += c->uvs_count;
+    vn += c->normals_count;
+    m += c->markers_count;
+  }
+
+  // every corner can be a new vertex, trimmed once the faces are merged
+  ctx->icount = 0;
+  ctx->indices = malloc(faces * 3 * sizeof(GLuint));
+
+  ctx->total_vertices = 0;
+  ctx->vertices = malloc(faces * 3 * sizeof(vertex));
+  ctx->first_vertex = ctx->first_index = 0;
+
+  // most corners of a mesh reuse its positions
+  ctx->vh = vertex_table_new(ctx->vcount * 2);
+
+  // a mesh per usemtl (at least one)
+  ctx->meshes_count = 0;
+  ctx->meshes = malloc((meshes_size > 0 ? meshes_size : 1) * sizeof(mesh));
+}
+
+// the mesh takes the vertices and indices pushed since the previous one,
+// its indices count from its first vertex
+static void push_mesh(importer_ctx* ctx) {
+  mesh* m = &ctx->meshes[ctx->meshes_count];
+  m->vertices = ctx->vertices + ctx->first_vertex;
+  m->indices = ctx->indices + ctx->first_index;
+  m->num_vertices = ctx->total_vertices - ctx->first_vertex;
+  m->num_indices = ctx->icount - ctx->first_index;
+  mesh_init_lods(m);
+  mesh_compute_tangent(m);
+  ctx->meshes_count++;
+
+  // corners shared with the next mesh get their own copy
+  ctx->first_vertex = ctx->total_vertices;
+  ctx->first_index = ctx->icount;
+  if (ctx->vh != NULL) {
+    ctx->vh->first = ctx->total_vertices;
+  }
+}
+
+static void apply_marker(importer_ctx* ctx, const char* asset, const obj_marker* m, int* first_mesh) {
+  // load mtl
+  if (m->type == MARKER_MTLLIB) {
+    import_mtl(ctx, asset);
+    return;
+  }
+
+  // use mtl
+  if (!*first_mesh) {
+    push_mesh(ctx);
+  } else {
+    *first_mesh = 0;
+  }
+
+  ctx->meshes[ctx->meshes_count].mat = *((material*)dict_search(ctx->materials, m->name));
+}
+
+static void merge_chunks(importer_ctx* ctx, const char* asset, obj_chunk* chunks, int count) {
+  // replay faces and materials in file order (keeps the serial index order)
+  int first_mesh = 1;
+  for (int i = 0; i < count; i++) {
+    obj_chunk* c = &chunks[i];
+    int marker = 0;
+
+    for (int f = 0; f <= c->faces_count; f++) {
+      while (marker < c->markers_count && c->markers[marker].face == c->face_offset + f) {
+        apply_marker(ctx, asset, &c->markers[marker++], &first_mesh);
+      }
+      if (f == c->faces_count) break;
+
+      // update indices
+      for (int k = 0; k < 3; k++) {
+        push_index(ctx, &c->corners[f * 3 + k]);
+      }
+    }
+  }
+}
+
+/* the original obj/mtl loader: fgets, a strstr probe per record type and
+   sscanf for every record, with face corners keyed by their text. only used
+   when importer_legacy is set, so importer_bench can time it against the
+   tokenizer. it reads the loose files, and a record matches wherever its
+   tag appears in the line (so "Tr" sets the reflectivity) */
+
+#define LEGACY_INIT_SIZE (256 * 10000)
+
+// capacities of the growing buffers
+typedef struct {
+  dict* vh;
+  int vsize, vtsize, vnsize, isize, total_vertices_size, meshes_size;
+} legacy_state;
+
+static void import_mtl_legacy(importer_ctx* ctx, const char* asset) {
   char mtl_path[256];
   if (!find_file_ext(asset, "mtl", mtl_path)) {
     printf("[importer] cannot find mtl file\n");
@@ -269,162 +872,110 @@ static void import_mtl(const char* asset) {
   strcat(tex_path, TEXTURES_PATH);
 
   char line[256];
+  char name[256];
   material* current_mat = NULL;
-  int first = 1;
   while (fgets(line, sizeof(line), file)) {
     // new material
     if (strstr(line, "newmtl ") != NULL) {
-      if (!first) {
-        dict_insert(materials, current_mat->name, current_mat);
-      } else {
-        first = 0;
+      if (current_mat != NULL) {
+        dict_insert(ctx->materials, current_mat->name, current_mat);
       }
       current_mat = (material*)malloc(sizeof(material));
       material_init(current_mat);
-      sscanf(line, "newmtl %s", current_mat->name);
+      sscanf(line, "newmtl %255s", current_mat->name);
     }
-    // texture path
+    else if (current_mat == NULL) {
+      continue;
+    }
+    // texture maps: assets/[asset]/textures/[map].png
     else if (strstr(line, "map_Kd ") != NULL) {
-      // assets/[asset]/textures/[diffuse].png
-      char diffuse_path[256];
-      sscanf(line, "map_Kd %s", diffuse_path);
+      sscanf(line, "map_Kd %255s", name);
       strcpy(current_mat->texture_path, tex_path);
-      strcat(current_mat->texture_path, diffuse_path);
+      strcat(current_mat->texture_path, name);
     }
-    // normal map path
     else if (strstr(line, "map_Kn ") != NULL) {
-      // assets/[asset]/textures/[normal].png
-      char normal_path[256];
-      sscanf(line, "map_Kn %s", normal_path);
+      sscanf(line, "map_Kn %255s", name);
       strcpy(current_mat->normal_map_path, tex_path);
-      strcat(current_mat->normal_map_path, normal_path);
+      strcat(current_mat->normal_map_path, name);
     }
-    // specular map path
     else if (strstr(line, "map_Ks ") != NULL) {
-      // assets/[asset]/textures/[specular].png
-      char specular_path[256];
-      sscanf(line, "map_Ks %s", specular_path);
+      sscanf(line, "map_Ks %255s", name);
       strcpy(current_mat->specular_map_path, tex_path);
-      strcat(current_mat->specular_map_path, specular_path);
+      strcat(current_mat->specular_map_path, name);
     }
-    // mask map path
     else if (strstr(line, "map_d ") != NULL) {
-      // assets/[asset]/textures/[normal].png
-      char mask_path[256];
-      sscanf(line, "map_d %s", mask_path);
+      sscanf(line, "map_d %255s", name);
       strcpy(current_mat->mask_map_path, tex_path);
-      strcat(current_mat->mask_map_path, mask_path);
+      strcat(current_mat->mask_map_path, name);
     }
     // diffuse
     else if (strstr(line, "Kd ") != NULL) {
-      sscanf(line, "Kd %f %f %f\n", &current_mat->diffuse[0], &current_mat->diffuse[1], &current_mat->diffuse[2]);
+      sscanf(line, "Kd %f %f %f", &current_mat->diffuse[0], &current_mat->diffuse[1], &current_mat->diffuse[2]);
     }
     // specular
     else if (strstr(line, "Ks ") != NULL) {
-      sscanf(line, "Ks %f\n", &current_mat->specular, &current_mat->specular, &current_mat->specular);
+      sscanf(line, "Ks %f", &current_mat->specular);
     }
     else if (strstr(line, "r ") != NULL) {
-      sscanf(line, "r %f\n", &current_mat->reflectivity);
+      sscanf(line, "r %f", &current_mat->reflectivity);
     }
   }
 
   if (current_mat != NULL) {
-    dict_insert(materials, current_mat->name, current_mat);
+    dict_insert(ctx->materials, current_mat->name, current_mat);
   }
 
   fclose(file);
 }
 
-static void push_index(const char* vkey) {
-  // search face in the hashmap
-  int* found = dict_search(vh, vkey);
+static void push_index_legacy(importer_ctx* ctx, legacy_state* st, const char* vkey) {
+  // search face in the hashmap, corners of earlier meshes get their own copy
+  int* found = dict_search(st->vh, vkey);
+  if (found != NULL && *found >= ctx->first_vertex) {
+    ctx->indices[ctx->icount++] = *found - ctx->first_vertex;
+    return;
+  }
+
+  // get vertex indices (vertex, texcoords, normals)
+  face_corner fc = { 0, 0, 0 };
+  if (sscanf(vkey, "%d/%d/%d", &fc.v, &fc.vt, &fc.vn) != 3) {
+    fc.vt = fc.vn = 0;
+    sscanf(vkey, "%d//%d", &fc.v, &fc.vn);
+  }
+
+  if (fc.v < 1 || fc.v > ctx->vcount || fc.vt < 0 || fc.vt > ctx->vtcount || fc.vn < 0 || fc.vn > ctx->vncount) {
+    printf("[importer] bad face corner: %s\n", vkey);
+    exit(1);
+  }
 
-  // get index from hashtable (or insert it if not present)
   if (found != NULL) {
-    indices[icount] = *found;
+    *found = ctx->total_vertices;
   } else {
-    // get vertex indices (vertex, texcoords, normals)
-    int v_index, vt_index, vn_index = -1;
-    int matches = sscanf(vkey, "%d/%d/%d", &v_index, &vt_index, &vn_index);
-    if (matches != 3) {
-      v_index = vt_index = vn_index = -1;
-      matches = sscanf(vkey, "%d//%d", &v_index, &vn_index);
-    }
-
-    v_index--; vt_index--; vn_index--;
-
-    // push vertex
-    vertices[total_vertices].x = temp_vertices[v_index][0];
-    vertices[total_vertices].y = temp_vertices[v_index][1];
-    vertices[total_vertices].z = temp_vertices[v_index][2];
-    vertices[total_vertices].u = vt_index >= 0 ? temp_uvs[vt_index][0] : 0.0f;
-    vertices[total_vertices].v = vt_index >= 0 ? temp_uvs[vt_index][1] : 0.0f;
-    vertices[total_vertices].nx = vn_index >= 0 ? temp_normals[vn_index][0] : 0.0f;
-    vertices[total_vertices].ny = vn_index >= 0 ? temp_normals[vn_index][1] : 0.0f;
-    vertices[total_vertices].nz = vn_index >= 0 ? temp_normals[vn_index][2] : 0.0f;
-
-    if (has_skl_file) {
-      vertices[total_vertices].jx = vweights[v_index].joint_ids[0];
-      vertices[total_vertices].jy = vweights[v_index].joint_ids[1];
-      vertices[total_vertices].jz = vweights[v_index].joint_ids[2];
-      vertices[total_vertices].wx = vweights[v_index].weights[0];
-      vertices[total_vertices].wy = vweights[v_index].weights[1];
-      vertices[total_vertices].wz = vweights[v_index].weights[2];
-    }
-    
-    // update indices
     int* index = malloc(sizeof(int));
-    *index = total_vertices;
-    dict_insert(vh, vkey, index);
-    indices[icount] = total_vertices;
+    *index = ctx->total_vertices;
+    dict_insert(st->vh, vkey, index);
+  }
 
-    total_vertices++;
+  ctx->indices[ctx->icount++] = ctx->total_vertices - ctx->first_vertex;
+  push_vertex(ctx, &fc);
 
-    // Increase vertices size
-    if (total_vertices >= total_vertices_size) {
-      total_vertices_size *= 2;
-      vertices = realloc(vertices, total_vertices_size * sizeof(vertex));
-    }
+  // increase vertices size
+  if (ctx->total_vertices >= st->total_vertices_size) {
+    st->total_vertices_size *= 2;
+    ctx->vertices = realloc(ctx->vertices, st->total_vertices_size * sizeof(vertex));
   }
-  icount++;
 }
 
-static void init_structures() {
-  // temp vertices
-  vsize = INIT_SIZE;
-  vcount = 0;
-  temp_vertices = malloc(vsize * sizeof(vec3));
-
-  // temp uvs
-  vtsize = INIT_SIZE;
-  vtcount = 0;
-  temp_uvs = malloc(vtsize * sizeof(vec2));
-  
-  // temp normals
-  vnsize = INIT_SIZE;
-  vncount = 0;
-  temp_normals = malloc(vnsize * sizeof(vec3));
-
-  // temp indices
-  isize = INIT_SIZE;
-  icount = 0;
-  indices = malloc(isize * sizeof(GLuint));
-
-  // vertices to return
-  total_vertices_size = INIT_SIZE;
-  total_vertices = 0;
-  vertices = malloc(total_vertices_size * sizeof(vertex));
-
-  // init hastable (it will be resized if needed)
-  vh = dict_new(INIT_SIZE);
-
-  // meshes
-  meshes_count = 0;
-  meshes_size = INIT_SIZE;
-  meshes = malloc(meshes_size * sizeof(mesh));
+// doubles a buffer of count elements once it is full
+static void* grow_legacy(void* buffer, int count, int* size, size_t element_size) {
+  if (count < *size) {
+    return buffer;
+  }
+  *size *= 2;
+  return realloc(buffer, *size * element_size);
 }
 
-object* importer_load(const char* asset) {
+static object* import_obj_legacy(importer_ctx* ctx, const char* asset, skeleton* skel) {
   // find asset/asset.obj
   char obj_path[256];
   if (!find_file_ext(asset, "obj", obj_path)) {
@@ -434,148 +985,839 @@ object* importer_load(const char* asset) {
 
   printf("[importer] found %s\n", obj_path);
 
-  /* parse vertices */
   FILE* file = fopen(obj_path, "r");
-  char line[256];
-
   if (file == NULL) {
     printf("[importer] cannot find file: %s\n", obj_path);
     exit(1);
   }
 
-  init_structures();
-  
-  // import skl and anm
-  skeleton* skel = NULL;
-  has_skl_file = 0;
-  if (find_file_ext(asset, "skl", NULL)) {
-    has_skl_file = 1;
-    skel = import_skl(asset);
-    import_animations(asset, skel);
-  }
-
-  // materials dictionary
-  materials = dict_new(INIT_SIZE);
+  // every buffer starts large and doubles when full
+  legacy_state st;
+  st.vsize = st.vtsize = st.vnsize = st.isize = st.total_vertices_size = LEGACY_INIT_SIZE;
+  st.meshes_size = 16;
+  st.vh = dict_new(LEGACY_INIT_SIZE);
+
+  ctx->vcount = ctx->vtcount = ctx->vncount = ctx->icount = 0;
+  ctx->total_vertices = ctx->first_vertex = ctx->first_index = 0;
+  ctx->temp_vertices = malloc(st.vsize * sizeof(vec3));
+  ctx->temp_uvs = malloc(st.vtsize * sizeof(vec2));
+  ctx->temp_normals = malloc(st.vnsize * sizeof(vec3));
+  ctx->indices = malloc(st.isize * sizeof(GLuint));
+  ctx->vertices = malloc(st.total_vertices_size * sizeof(vertex));
+  ctx->meshes_count = 0;
+  ctx->meshes = malloc(st.meshes_size * sizeof(mesh));
+  ctx->materials = dict_new(LEGACY_INIT_SIZE);
 
+  char line[256];
   int first_mesh = 1;
   while (fgets(line, sizeof(line), file)) {
-
     // realloc indices list
-    if (icount + 3 >= isize) {
-      isize = isize * 2;
-      indices = realloc(indices, isize * sizeof(GLuint));
+    if (ctx->icount + 3 >= st.isize) {
+      st.isize *= 2;
+      ctx->indices = realloc(ctx->indices, st.isize * sizeof(GLuint));
     }
 
     // new vertex
     if (strstr(line, "v ") != NULL) {
-      sscanf(line, "v %f %f %f", &temp_vertices[vcount][0], &temp_vertices[vcount][1], &temp_vertices[vcount][2]);
-      vcount++;
-
-      // realloc vertices list
-      if (vcount >= vsize) {
-        vsize *= 2;
-        temp_vertices = realloc(temp_vertices, vsize * sizeof(vec3));
-      }
+      float* v = ctx->temp_vertices[ctx->vcount++];
+      sscanf(line, "v %f %f %f", &v[0], &v[1], &v[2]);
+      ctx->temp_vertices = grow_legacy(ctx->temp_vertices, ctx->vcount, &st.vsize, sizeof(vec3));
     }
 
     // new texcoords
     if (strstr(line, "vt ") != NULL) {
-      sscanf(line, "vt %f %f", &temp_uvs[vtcount][0], &temp_uvs[vtcount][1]);
-      vtcount++;
-
-      // realloc uvs list
-      if (vtcount >= vtsize) {
-        vtsize *= 2;
-        temp_uvs = realloc(temp_uvs, vtsize * sizeof(vec2));
-      }
+      float* vt = ctx->temp_uvs[ctx->vtcount++];
+      sscanf(line, "vt %f %f", &vt[0], &vt[1]);
+      ctx->temp_uvs = grow_legacy(ctx->temp_uvs, ctx->vtcount, &st.vtsize, sizeof(vec2));
     }
 
     // new normal
     if (strstr(line, "vn ") != NULL) {
-      sscanf(line, "vn %f %f %f", &temp_normals[vncount][0], &temp_normals[vncount][1], &temp_normals[vncount][2]);
-      vncount++;
-
-      // realloc vertices list
-      if (vncount >= vnsize) {
-        vnsize *= 2;
-        temp_normals = realloc(temp_normals, vnsize * sizeof(vec3));
-      }
+      float* vn = ctx->temp_normals[ctx->vncount++];
+      sscanf(line, "vn %f %f %f", &vn[0], &vn[1], &vn[2]);
+      ctx->temp_normals = grow_legacy(ctx->temp_normals, ctx->vncount, &st.vnsize, sizeof(vec3));
     }
 
     // new face
     if (strstr(line, "f ") != NULL) {
-
-      // parse vertices of current face
-      char v1[128];
-      char v2[128];
-      char v3[128];
-      sscanf(line, "f %s %s %s", v1, v2, v3);
-
-      // update indices
-      push_index(v1);
-      push_index(v2);
-      push_index(v3);
+      char v1[256], v2[256], v3[256];
+      if (sscanf(line, "f %255s %255s %255s", v1, v2, v3) == 3) {
+        push_index_legacy(ctx, &st, v1);
+        push_index_legacy(ctx, &st, v2);
+        push_index_legacy(ctx, &st, v3);
+      }
     }
 
     // load mtl
     if (strstr(line, "mtllib ") != NULL) {
-      import_mtl(asset);
+      import_mtl_legacy(ctx, asset);
     }
 
     // use mtl
     if (strstr(line, "usemtl") != NULL) {
       if (!first_mesh) {
-        meshes[meshes_count].vertices = vertices;
-        meshes[meshes_count].indices = indices;
-        meshes[meshes_count].num_vertices = total_vertices;
-        meshes[meshes_count].num_indices = icount;
-        mesh_compute_tangent(&meshes[meshes_count]);
-        meshes_count++;
+        push_mesh(ctx);
+        ctx->meshes = grow_legacy(ctx->meshes, ctx->meshes_count, &st.meshes_size, sizeof(mesh));
       } else {
         first_mesh = 0;
       }
 
-      char mtl_name[128];
-      sscanf(line, "usemtl %s\n", mtl_name);
-      meshes[meshes_count].mat = *((material*)dict_search(materials, mtl_name));
+      char mtl_name[256];
+      sscanf(line, "usemtl %255s", mtl_name);
+      ctx->meshes[ctx->meshes_count].mat = *((material*)dict_search(ctx->materials, mtl_name));
     }
   }
 
   // push last mesh
-  meshes[meshes_count].vertices = vertices;
-  meshes[meshes_count].indices = indices;
-  meshes[meshes_count].num_vertices = total_vertices;
-  meshes[meshes_count].num_indices = icount;
-  mesh_compute_tangent(&meshes[meshes_count]);
-  meshes_count++;
+  push_mesh(ctx);
+
+  fclose(file);
+
+  // the buffers moved while growing, point the meshes at their final place
+  ctx->vertices = realloc(ctx->vertices, (ctx->total_vertices > 0 ? ctx->total_vertices : 1) * sizeof(vertex));
+  ctx->indices = realloc(ctx->indices, (ctx->icount > 0 ? ctx->icount : 1) * sizeof(GLuint));
+  for (int i = 0, vertex_offset = 0, index_offset = 0; i < ctx->meshes_count; i++) {
+    ctx->meshes[i].vertices = ctx->vertices + vertex_offset;
+    ctx->meshes[i].indices = ctx->indices + index_offset;
+    vertex_offset += ctx->meshes[i].num_vertices;
+    index_offset += ctx->meshes[i].num_indices;
+  }
+
+  dict_free(st.vh);
+  dict_free(ctx->materials);
+  free(ctx->temp_vertices);
+  free(ctx->temp_uvs);
+  free(ctx->temp_normals);
+
+  object* o = object_create(NULL, 1.0f, ctx->meshes, ctx->meshes_count, 1, skel);
+
+  ctx->materials = NULL;
+  ctx->temp_vertices = NULL;
+  ctx->temp_uvs = NULL;
+  ctx->temp_normals = NULL;
+  ctx->indices = NULL;
+  ctx->vertices = NULL;
+  ctx->meshes = NULL;
+
+  return o;
+}
+
+static object* import_obj(importer_ctx* ctx, const char* asset, skeleton* skel) {
+  // find asset/asset.obj
+  char obj_path[256];
+  if (!find_file_ext(asset, "obj", obj_path)) {
+    printf("[importer] cannot find obj file\n");
+    exit(1);
+  }
+
+  printf("[importer] found %s\n", obj_path);
+
+  vfs_file file;
+  if (!vfs_open(obj_path, &file)) {
+    printf("[importer] cannot find file: %s\n", obj_path);
+    exit(1);
+  }
+
+  // materials dictionary
+  ctx->materials = dict_new(16);
+
+  // count records, size the buffers, then parse in parallel and merge on this thread
+  obj_chunk chunks[IMPORTER_MAX_THREADS];
+  int chunk_count = split_chunks(&file, chunks);
+  run_chunks(chunks, chunk_count, count_chunk);
+  init_structures(ctx, chunks, chunk_count);
+  run_chunks(chunks, chunk_count, parse_chunk);
+  merge_chunks(ctx, asset, chunks, chunk_count);
+
+  // push last mesh
+  push_mesh(ctx);
+
+  // trim the vertex buffer shared by the meshes
+  ctx->vertices = realloc(ctx->vertices, (ctx->total_vertices > 0 ? ctx->total_vertices : 1) * sizeof(vertex));
+  for (int i = 0, offset = 0; i < ctx->meshes_count; i++) {
+    ctx->meshes[i].vertices = ctx->vertices + offset;
+    offset += ctx->meshes[i].num_vertices;
+  }
+
+  vfs_close(&file);
+
+  vertex_table_free(ctx->vh);
+  dict_free(ctx->materials);
+
+  object* o = object_create(NULL, 1.0f, ctx->meshes, ctx->meshes_count, 1, skel);
+
+  ctx->vh = NULL;
+  ctx->materials = NULL;
+  ctx->temp_vertices = NULL;
+  ctx->temp_uvs = NULL;
+  ctx->temp_normals = NULL;
+  ctx->indices = NULL;
+  ctx->vertices = NULL;
+  ctx->meshes = NULL;
+
+  return o;
+}
+
+/* baked meshes (.smesh): header, mesh records, then the final vertex and
+   index buffers, and the streams the gpu reads (packed vertices, their skin
+   and the indices as uploaded), aligned so they can be used straight from
+   the mapping. each mesh owns the next num_vertices vertices, and the
+   indices of all its detail levels, finest first */
+typedef struct {
+  char magic[4];
+  int version;
+
+  // obj and mtl the file was baked from
+  long long obj_mtime, obj_size;
+  long long mtl_mtime, mtl_size;
+
+  // skl and anm files, joint ids of the vertices are sorted by the skeleton
+  unsigned long long skeleton_hash;
+
+  int mesh_count;
+  int vertex_count;
+  int index_count;
+  vec3 center;
+  vec3 min, max;
+
+  long long vertex_offset;
+  long long index_offset;
+
+  // skin_offset is 0 for static meshes. gpu indices are 16 bit when no mesh
+  // has more vertices than that, else they are the 32 bit ones
+  long long packed_offset;
+  long long skin_offset;
+  long long gpu_index_offset;
+  int gpu_index_size;
+} smesh_header;
+
+typedef struct {
+  material mat;
+  GLuint num_vertices;
+  int num_lods;
+  GLuint lod_indices[MESH_MAX_LODS];
+  float lod_error[MESH_MAX_LODS];
+  vec3 center;
+  float radius;
+  float uv_density;
+} smesh_mesh;
+
+// offset of the region after one of size bytes at offset, aligned to 16
+static long long smesh_next(long long offset, long long size) {
+  return (offset + size + 15) & ~15LL;
+}
+
+// region of count elements of size bytes at offset, inside a file of file_size
+static int smesh_fits(long long offset, long long count, long long size, long long file_size) {
+  return offset >= 0 && offset <= file_size && count * size <= file_size - offset;
+}
+
+// every index of every level of every mesh points at a vertex of its mesh
+static int smesh_indices_valid(const smesh_mesh* records, int mesh_count, const char* indices, int index_size) {
+  for (int i = 0; i < mesh_count; i++) {
+    long long count = 0;
+    for (int l = 0; l < records[i].num_lods; l++) {
+      count += records[i].lod_indices[l];
+    }
+    for (long long k = 0; k < count; k++) {
+      GLuint index = index_size == 2 ? ((const GLushort*)indices)[k] : ((const GLuint*)indices)[k];
+      if (index >= records[i].num_vertices) return 0;
+    }
+    indices += count * index_size;
+  }
+  return 1;
+}
+
+static void source_stamp(const char* asset, const char* ext, long long* mtime, long long* size) {
+  char path[256];
+  if (!find_file_ext(asset, ext, path) || !vfs_stat(path, mtime, size)) {
+    *mtime = *size = -1;
+  }
+}
+
+// names, mtimes and sizes of the skl and anm files of asset
+static unsigned long long skeleton_sources_hash(const char* asset) {
+  char dir[256];
+  strcpy(dir, ASSETS_PATH);
+  strcat(dir, asset);
+  strcat(dir, "/");
+
+  const char* exts[2] = { "skl", "anm" };
+  unsigned long long sum = 0;
+  for (int e = 0; e < 2; e++) {
+    char names[OBJECT_MAX_ANIMS][256];
+    int count = vfs_list(dir, exts[e], names, OBJECT_MAX_ANIMS);
+
+    // order independent
+    for (int i = 0; i < count; i++) {
+      char path[512];
+      long long mtime, size;
+      snprintf(path, sizeof(path), "%s%s", dir, names[i]);
+      if (!vfs_stat(path, &mtime, &size)) continue;
+
+      unsigned long long h = vfs_hash(names[i], strlen(names[i]));
+      h = (h ^ (unsigned long long)(mtime / 1000000000LL)) * 1099511628211ULL;
+      h = (h ^ (unsigned long long)(mtime % 1000000000LL)) * 1099511628211ULL;
+      h = (h ^ (unsigned long long)size) * 1099511628211ULL;
+      sum += h;
+    }
+  }
+
+  return sum;
+}
+
+static void smesh_path(const char* dir, const char* asset, char* out) {
+  sprintf(out, "%s%s/%s.smesh", dir, asset, asset);
+}
+
+// loads asset/asset.smesh, NULL when it is missing, stale or from another version
+static object* load_smesh(const char* asset, skeleton* skel) {
+  char path[256];
+  smesh_path(ASSETS_PATH, asset, path);
+
+  // read only: the meshes point into the mapping, and baked meshes are never
+  // edited after loading
+  vfs_file file;
+  if (!vfs_open(path, &file)) {
+    return NULL;
+  }
+  if (file.size < sizeof(smesh_header)) {
+    vfs_close(&file);
+    return NULL;
+  }
+
+  const char* data = file.data;
+  size_t size = file.size;
+  const smesh_header* h = (const smesh_header*)data;
+  long long obj_mtime, obj_size, mtl_mtime, mtl_size;
+  source_stamp(asset, "obj", &obj_mtime, &obj_size);
+  source_stamp(asset, "mtl", &mtl_mtime, &mtl_size);
+
+  int valid = memcmp(h->magic, "SMSH", 4) == 0 && h->version == IMPORTER_SMESH_VERSION;
+  int fresh = valid && h->obj_mtime == obj_mtime && h->obj_size == obj_size &&
+    h->mtl_mtime == mtl_mtime && h->mtl_size == mtl_size &&
+    h->skeleton_hash == skeleton_sources_hash(asset);
+  // counts and offsets are signed in the file: all sizes are compared as long
+  // long, and negative ones are never complete
+  long long file_size = size;
+  int complete = valid && h->mesh_count > 0 && h->vertex_count >= 0 && h->index_count >= 0 &&
+    (h->gpu_index_size == 2 || h->gpu_index_size == 4) &&
+    smesh_fits(h->vertex_offset, h->vertex_count, sizeof(vertex), file_size) &&
+    smesh_fits(h->index_offset, h->index_count, sizeof(GLuint), file_size) &&
+    smesh_fits(h->packed_offset, h->vertex_count, sizeof(vertex_packed), file_size) &&
+    smesh_fits(h->gpu_index_offset, h->index_count, h->gpu_index_size, file_size) &&
+    (skel == NULL || (h->skin_offset > 0 && smesh_fits(h->skin_offset, h->vertex_count, sizeof(vertex_skin), file_size))) &&
+    (long long)sizeof(smesh_header) + h->mesh_count * (long long)sizeof(smesh_mesh) <= h->vertex_offset;
+
+  // the mesh ranges must fit in the buffers
+  if (complete) {
+    long long vertex_sum = 0, index_sum = 0;
+    const smesh_mesh* records = (const smesh_mesh*)(data + sizeof(smesh_header));
+    for (int i = 0; i < h->mesh_count && complete; i++) {
+      vertex_sum += records[i].num_vertices;
+      complete = records[i].num_lods >= 1 && records[i].num_lods <= MESH_MAX_LODS;
+      for (int l = 0; l < records[i].num_lods && complete; l++) {
+        index_sum += records[i].lod_indices[l];
+      }
+    }
+    complete = complete && vertex_sum == h->vertex_count && index_sum == h->index_count;
+  }
+
+  // the cpu and the gpu indices must stay inside their meshes
+  if (fresh && complete) {
+    const smesh_mesh* records = (const smesh_mesh*)(data + sizeof(smesh_header));
+    complete = smesh_indices_valid(records, h->mesh_count, data + h->index_offset, sizeof(GLuint)) &&
+      (h->gpu_index_offset == h->index_offset ||
+       smesh_indices_valid(records, h->mesh_count, data + h->gpu_index_offset, h->gpu_index_size));
+  }
+
+  if (!fresh || !complete) {
+    printf("[importer] %s is %s, parsing obj\n", path, !valid ? "not a baked mesh" : !fresh ? "stale" : "corrupt");
+    vfs_close(&file);
+    return NULL;
+  }
+
+  printf("[importer] found %s\n", path);
+
+  vertex* vertices = (vertex*)(data + h->vertex_offset);
+  GLuint* indices = (GLuint*)(data + h->index_offset);
+  const smesh_mesh* records = (const smesh_mesh*)(data + sizeof(smesh_header));
+
+  mesh* meshes = malloc(h->mesh_count * sizeof(mesh));
+  for (int i = 0; i < h->mesh_count; i++) {
+    meshes[i].vertices = vertices;
+    meshes[i].indices = indices;
+    meshes[i].num_vertices = records[i].num_vertices;
+    meshes[i].num_indices = records[i].lod_indices[0];
+    meshes[i].num_lods = records[i].num_lods;
+    memcpy(meshes[i].lod_indices, records[i].lod_indices, sizeof(records[i].lod_indices));
+    memcpy(meshes[i].lod_error, records[i].lod_error, sizeof(records[i].lod_error));
+    meshes[i].mat = records[i].mat;
+    vec3_copy(meshes[i].center, records[i].center);
+    meshes[i].radius = records[i].radius;
+    meshes[i].uv_density = records[i].uv_density;
+    vertices += records[i].num_vertices;
+    indices += mesh_total_indices(&meshes[i]);
+  }
+
+  // tangents, bounds and the gpu streams were computed when baking
+  object* o = object_create(NULL, 1.0f, meshes, h->mesh_count, 0, skel);
+  vec3_copy(o->center, h->center);
+  o->mapping = file;
+  o->streams.packed = (const vertex_packed*)(data + h->packed_offset);
+  o->streams.skin = skel != NULL ? (const vertex_skin*)(data + h->skin_offset) : NULL;
+  o->streams.indices = data + h->gpu_index_offset;
+  o->streams.index_type = h->gpu_index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+  return o;
+}
+
+/* baked skeletons and clips (.sanim): header, rest pose, vertex weights,
+   then every clip with its keyframe times and its translations and
+   rotations, already decomposed and laid out as the clip stores them */
+typedef struct {
+  char magic[4];
+  int version;
 
+  // names, mtimes and sizes of the skl and anm files it was baked from
+  unsigned long long source_hash;
+
+  int joint_count;
+  int weight_count;
+  int clip_count;
+} sanim_header;
+
+typedef struct {
+  char name[256];
+  int keyframe_count;
+  int frame_count;
+} sanim_clip;
+
+static void sanim_path(const char* dir, const char* asset, char* out) {
+  sprintf(out, "%s%s/%s.sanim", dir, asset, asset);
+}
+
+// next 'size' bytes of the file, NULL past its end
+static const void* take(const char** p, const char* end, size_t size) {
+  if ((size_t)(end - *p) < size) {
+    return NULL;
+  }
+  const void* data = *p;
+  *p += size;
+  return data;
+}
+
+// loads asset/asset.sanim into a new skeleton and the ctx clips and weights,
+// NULL when it is missing, stale or from another version
+static skeleton* load_sanim(importer_ctx* ctx, const char* asset) {
+  char path[256];
+  sanim_path(ASSETS_PATH, asset, path);
+
+  vfs_file file;
+  if (!vfs_open(path, &file)) {
+    return NULL;
+  }
+
+  const char* p = file.data;
+  const char* end = file.data + file.size;
+  const sanim_header* h = take(&p, end, sizeof(sanim_header));
+
+  int valid = h != NULL && memcmp(h->magic, "SANM", 4) == 0 && h->version == IMPORTER_SANIM_VERSION &&
+    h->joint_count > 0 && h->joint_count < MAX_JOINTS && h->weight_count >= 0 &&
+    h->clip_count >= 0 && h->clip_count <= OBJECT_MAX_ANIMS;
+  if (!valid || h->source_hash != skeleton_sources_hash(asset)) {
+    printf("[importer] %s is %s, parsing skl and anm\n", path, valid ? "stale" : "not a baked skeleton");
+    vfs_close(&file);
+    return NULL;
+  }
+
+  printf("[importer] found %s\n", path);
+
+  int jc = h->joint_count;
+  const char* names = take(&p, end, 256);
+  const int* parents = take(&p, end, jc * sizeof(int));
+  const float* joints = take(&p, end, POSE_CHANNELS * jc * sizeof(float));
+  const mat4* inv = take(&p, end, jc * sizeof(mat4));
+  const vertex_weights* weights = take(&p, end, h->weight_count * sizeof(vertex_weights));
+
+  skeleton* skl = NULL;
+  if (names == NULL || parents == NULL || joints == NULL || inv == NULL || weights == NULL) {
+    goto truncated;
+  }
+  for (int i = 0; i < jc; i++) {
+    if (parents[i] < -1 || parents[i] >= i) goto truncated;
+  }
+  // the skinning reads the joints of every weight a vertex has
+  int max_weights = sizeof(weights[0].joint_ids) / sizeof(weights[0].joint_ids[0]);
+  for (int i = 0; i < h->weight_count; i++) {
+    if (weights[i].count < 0 || weights[i].count > max_weights) goto truncated;
+    for (int j = 0; j < weights[i].count; j++) {
+      if (weights[i].joint_ids[j] < 0 || weights[i].joint_ids[j] >= jc) goto truncated;
+    }
+  }
+
+  // rest pose
+  skl = skeleton_create();
+  skl->joint_count = jc;
+  memcpy(skl->joint_names, names, 256);
+  frame* rest = &skl->rest_pose;
+  rest->joint_count = jc;
+  memcpy(rest->joint_parents, parents, jc * sizeof(int));
+  for (int c = 0; c < POSE_CHANNELS; c++) {
+    memcpy(rest->joints[c], &joints[c * jc], jc * sizeof(float));
+  }
+  memcpy(rest->transforms_inv, inv, jc * sizeof(mat4));
+  frame_gen_transforms(rest, NULL);
+
+  // weights
+  ctx->weight_count = h->weight_count;
+  ctx->vweights = arena_alloc(&ctx->load_arena, h->weight_count * sizeof(vertex_weights));
+  memcpy(ctx->vweights, weights, h->weight_count * sizeof(vertex_weights));
+
+  // clips
+  for (int c = 0; c < h->clip_count; c++) {
+    const sanim_clip* clip = take(&p, end, sizeof(sanim_clip));
+    if (clip == NULL || memchr(clip->name, '\0', sizeof(clip->name)) == NULL) goto truncated;
+
+    // sampling clamps to frame_count - 1 and reads that keyframe
+    int kc = clip->keyframe_count;
+    if (kc < 1 || clip->frame_count < 1 || clip->frame_count > kc) goto truncated;
+    size_t size = (size_t)kc * POSE_CHANNELS * frame_lanes(jc) * sizeof(float);
+    const float* times = take(&p, end, kc * sizeof(float));
+    const float* channels = take(&p, end, size);
+    if (times == NULL || channels == NULL) goto truncated;
+
+    animation* anm = animation_create(clip->name, jc);
+    for (int k = 0; k < kc; k++) {
+      animation_add_keyframe(anm, times[k], rest);
+    }
+    memcpy(anm->channels, channels, size);
+    anm->frame_count = clip->frame_count;
+
+    ctx->animations[ctx->animation_count++] = anm;
+  }
+
+  vfs_close(&file);
+  return skl;
+
+truncated:
+  printf("[importer] %s is truncated or corrupt, parsing skl and anm\n", path);
+  for (int i = 0; i < ctx->animation_count; i++) {
+    animation_free(ctx->animations[i]);
+  }
+  ctx->animation_count = 0;
+  if (skl != NULL) {
+    skeleton_free(skl);
+  }
+  vfs_close(&file);
+  return NULL;
+}
+
+static int bake_sanim(importer_ctx* ctx, const char* asset, skeleton* skl, const char* out_dir) {
+  char path[512];
+  sanim_path(out_dir, asset, path);
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    printf("[importer] cannot write %s\n", path);
+    return 0;
+  }
+
+  sanim_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "SANM", 4);
+  h.version = IMPORTER_SANIM_VERSION;
+  h.source_hash = skeleton_sources_hash(asset);
+  h.joint_count = skl->joint_count;
+  h.weight_count = ctx->weight_count;
+  h.clip_count = ctx->animation_count;
+  fwrite(&h, sizeof(h), 1, file);
+
+  int jc = skl->joint_count;
+  frame* rest = &skl->rest_pose;
+  fwrite(skl->joint_names, 1, 256, file);
+  fwrite(rest->joint_parents, sizeof(int), jc, file);
+  for (int c = 0; c < POSE_CHANNELS; c++) {
+    fwrite(rest->joints[c], sizeof(float), jc, file);
+  }
+  fwrite(rest->transforms_inv, sizeof(mat4), jc, file);
+  fwrite(ctx->vweights, sizeof(vertex_weights), ctx->weight_count, file);
+
+  for (int c = 0; c < ctx->animation_count; c++) {
+    animation* a = ctx->animations[c];
+
+    sanim_clip clip;
+    memset(&clip, 0, sizeof(clip));
+    strcpy(clip.name, a->name);
+    clip.keyframe_count = a->keyframe_count;
+    clip.frame_count = a->frame_count;
+    fwrite(&clip, sizeof(clip), 1, file);
+    fwrite(a->keyframes, sizeof(float), a->keyframe_count, file);
+    fwrite(a->channels, sizeof(float), (size_t)a->keyframe_count * POSE_CHANNELS * a->stride, file);
+  }
+
+  int ok = ferror(file) == 0;
   fclose(file);
 
-  dict_free(vh);
-  free(temp_vertices);
-  free(temp_uvs);
-  free(temp_normals);
-  dict_free(materials);
+  printf("[importer] baked %s (%d joints, %d clips)\n", path, h.joint_count, h.clip_count);
+  return ok;
+}
+
+// bake_dir is where baked files are written, NULL to load them when they are fresh
+static object* load_asset(importer_ctx* ctx, const char* asset, const char* bake_dir) {
+  arena_init(&ctx->load_arena, ARENA_BLOCK_SIZE);
+  int use_baked = bake_dir == NULL && importer_baked && !importer_legacy;
 
-  if (has_skl_file) {
-    free(vweights);
+  // import skl and anm (baked or text)
+  skeleton* skel = NULL;
+  ctx->has_skl_file = 0;
+  if (find_file_ext(asset, "skl", NULL)) {
+    ctx->has_skl_file = 1;
+    skel = use_baked ? load_sanim(ctx, asset) : NULL;
+    if (skel == NULL) {
+      skel = import_skl(ctx, asset);
+      import_animations(ctx, asset, skel);
+      if (bake_dir != NULL) {
+        bake_sanim(ctx, asset, skel, bake_dir);
+      }
+    }
   }
 
-  object* o = object_create(NULL, 1.0f, meshes, meshes_count, 1, skel);
+  object* o = use_baked ? load_smesh(asset, skel) : NULL;
+  if (o == NULL) {
+    o = importer_legacy ? import_obj_legacy(ctx, asset, skel) : import_obj(ctx, asset, skel);
+  }
 
-  temp_vertices = NULL;
-  temp_uvs = NULL;
-  temp_normals = NULL;
-  indices = NULL;
-  vertices = NULL;
-  meshes = NULL;
-  vweights = NULL;
+  arena_free(&ctx->load_arena);
+  ctx->vweights = NULL;
 
-  for (int i = 0; i < animation_count; i++) {
-    object_add_animation(o, animations[i]);
-    animations[i] = NULL;
+  for (int i = 0; i < ctx->animation_count; i++) {
+    object_add_animation(o, ctx->animations[i]);
+    ctx->animations[i] = NULL;
   }
-  animation_count = 0;
+  ctx->animation_count = 0;
 
   return o;
 }
+
+object* importer_load_ctx(importer_ctx* ctx, const char* asset) {
+  return load_asset(ctx, asset, NULL);
+}
+
+int importer_bake(const char* asset, const char* out_dir) {
+  importer_ctx ctx = { 0 };
+  object* o = load_asset(&ctx, asset, out_dir);
+
+  // reorder for the gpu caches, weighting the statistics by mesh size
+  float acmr[2] = { 0.0f, 0.0f }, atvr[2] = { 0.0f, 0.0f };
+  int triangles = 0, vertex_total = 0;
+  for (int i = 0; i < o->num_meshes; i++) {
+    mesh* m = &o->meshes[i];
+    float before_acmr, before_atvr, after_acmr, after_atvr;
+    mesh_optimizer_stats(m, &before_acmr, &before_atvr);
+    mesh_optimizer_run(m);
+    mesh_optimizer_stats(m, &after_acmr, &after_atvr);
+
+    acmr[0] += before_acmr * (m->num_indices / 3);
+    acmr[1] += after_acmr * (m->num_indices / 3);
+    atvr[0] += before_atvr * m->num_vertices;
+    atvr[1] += after_atvr * m->num_vertices;
+    triangles += m->num_indices / 3;
+    vertex_total += m->num_vertices;
+  }
+  if (triangles > 0 && vertex_total > 0) {
+    printf("[importer] %s: acmr %.3f -> %.3f, atvr %.3f -> %.3f (fifo %d)\n", asset,
+      acmr[0] / triangles, acmr[1] / triangles, atvr[0] / vertex_total, atvr[1] / vertex_total, MESH_OPTIMIZER_CACHE_SIZE);
+  }
+
+  /* coarser levels follow each mesh's own indices, so the index buffer is
+     rebuilt with room for them: every level is at most 3/4 of the one
+     before it, and all of them together at most the mesh itself */
+  GLuint* indices = o->meshes[0].indices;
+  int index_total = 0;
+  for (int i = 0; i < o->num_meshes; i++) {
+    index_total += o->meshes[i].num_indices;
+  }
+
+  GLuint* lod_indices = malloc((index_total > 0 ? index_total : 1) * 2 * sizeof(GLuint));
+  GLuint* next = lod_indices;
+  int lod_triangles[MESH_MAX_LODS] = { 0 };
+  for (int i = 0; i < o->num_meshes; i++) {
+    mesh* m = &o->meshes[i];
+    memcpy(next, m->indices, m->num_indices * sizeof(GLuint));
+    m->indices = next;
+    next += m->num_indices;
+    next += mesh_simplifier_build_lods(m, next);
+
+    // meshes with fewer levels count their coarsest one in the others
+    for (int l = 0; l < MESH_MAX_LODS; l++) {
+      lod_triangles[l] += m->lod_indices[l < m->num_lods ? l : m->num_lods - 1] / 3;
+    }
+  }
+  free(indices);
+  printf("[importer] %s: lod triangles %d / %d / %d / %d\n", asset,
+    lod_triangles[0], lod_triangles[1], lod_triangles[2], lod_triangles[3]);
+
+  // meshes are consecutive ranges of one vertex and index buffer
+  vertex* vertices = o->meshes[0].vertices;
+  indices = o->meshes[0].indices;
+
+  smesh_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "SMSH", 4);
+  h.version = IMPORTER_SMESH_VERSION;
+  source_stamp(asset, "obj", &h.obj_mtime, &h.obj_size);
+  source_stamp(asset, "mtl", &h.mtl_mtime, &h.mtl_size);
+  h.skeleton_hash = skeleton_sources_hash(asset);
+  h.mesh_count = o->num_meshes;
+  for (int i = 0; i < o->num_meshes; i++) {
+    mesh_compute_bounds(&o->meshes[i]);
+    h.vertex_count += o->meshes[i].num_vertices;
+    h.index_count += mesh_total_indices(&o->meshes[i]);
+  }
+  vec3_copy(h.center, o->center);
+
+  for (int i = 0; i < h.vertex_count; i++) {
+    vertex* v = &vertices[i];
+    vec3 p = { v->x, v->y, v->z };
+    for (int k = 0; k < 3; k++) {
+      if (i == 0 || p[k] < h.min[k]) h.min[k] = p[k];
+      if (i == 0 || p[k] > h.max[k]) h.max[k] = p[k];
+    }
+  }
+
+  // the streams renderer_init_object would otherwise build on every upload
+  vertex_packed* packed = malloc((h.vertex_count > 0 ? h.vertex_count : 1) * sizeof(vertex_packed));
+  vertex_skin* skin = o->skel != NULL ? malloc((h.vertex_count > 0 ? h.vertex_count : 1) * sizeof(vertex_skin)) : NULL;
+  for (int i = 0; i < h.vertex_count; i++) {
+    vertex_pack(&vertices[i], &packed[i]);
+    if (skin != NULL) vertex_pack_skin(&vertices[i], &skin[i]);
+  }
+
+  h.gpu_index_size = sizeof(GLushort);
+  for (int i = 0; i < o->num_meshes; i++) {
+    if (o->meshes[i].num_vertices > 65536) h.gpu_index_size = sizeof(GLuint);
+  }
+  GLushort* short_indices = NULL;
+  if (h.gpu_index_size == sizeof(GLushort)) {
+    short_indices = malloc((h.index_count > 0 ? h.index_count : 1) * sizeof(GLushort));
+    for (int i = 0; i < h.index_count; i++) {
+      short_indices[i] = indices[i];
+    }
+  }
+
+  long long records_end = sizeof(smesh_header) + (long long)h.mesh_count * sizeof(smesh_mesh);
+  h.vertex_offset = smesh_next(records_end, 0);
+  h.index_offset = smesh_next(h.vertex_offset, (long long)h.vertex_count * sizeof(vertex));
+  h.packed_offset = smesh_next(h.index_offset, (long long)h.index_count * sizeof(GLuint));
+  long long end = smesh_next(h.packed_offset, (long long)h.vertex_count * sizeof(vertex_packed));
+  if (skin != NULL) {
+    h.skin_offset = end;
+    end = smesh_next(h.skin_offset, (long long)h.vertex_count * sizeof(vertex_skin));
+  }
+  h.gpu_index_offset = short_indices != NULL ? end : h.index_offset;
+
+  char path[512];
+  smesh_path(out_dir, asset, path);
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    printf("[importer] cannot write %s\n", path);
+    free(packed);
+    free(skin);
+    free(short_indices);
+    object_free(o);
+    free(o);
+    return 0;
+  }
+
+  fwrite(&h, sizeof(h), 1, file);
+  for (int i = 0; i < h.mesh_count; i++) {
+    smesh_mesh m;
+    memset(&m, 0, sizeof(m));
+    m.mat = o->meshes[i].mat;
+    m.num_vertices = o->meshes[i].num_vertices;
+    m.num_lods = o->meshes[i].num_lods;
+    memcpy(m.lod_indices, o->meshes[i].lod_indices, sizeof(m.lod_indices));
+    memcpy(m.lod_error, o->meshes[i].lod_error, sizeof(m.lod_error));
+    vec3_copy(m.center, o->meshes[i].center);
+    m.radius = o->meshes[i].radius;
+    m.uv_density = o->meshes[i].uv_density;
+    fwrite(&m, sizeof(m), 1, file);
+  }
+
+  // every region starts on the 16 byte boundary after the previous one
+  char pad[16] = { 0 };
+  fwrite(pad, 1, h.vertex_offset - records_end, file);
+  fwrite(vertices, sizeof(vertex), h.vertex_count, file);
+  fwrite(pad, 1, h.index_offset - ftell(file), file);
+  fwrite(indices, sizeof(GLuint), h.index_count, file);
+  fwrite(pad, 1, h.packed_offset - ftell(file), file);
+  fwrite(packed, sizeof(vertex_packed), h.vertex_count, file);
+  if (skin != NULL) {
+    fwrite(pad, 1, h.skin_offset - ftell(file), file);
+    fwrite(skin, sizeof(vertex_skin), h.vertex_count, file);
+  }
+  if (short_indices != NULL) {
+    fwrite(pad, 1, h.gpu_index_offset - ftell(file), file);
+    fwrite(short_indices, sizeof(GLushort), h.index_count, file);
+  }
+
+  int ok = ferror(file) == 0;
+  fclose(file);
+
+  free(packed);
+  free(skin);
+  free(short_indices);
+
+  printf("[importer] baked %s (%d vertices, %d indices)\n", path, h.vertex_count, h.index_count);
+
+  object_free(o);
+  free(o);
+  return ok;
+}
+
+importer_ctx* importer_ctx_new() {
+  importer_ctx* ctx = calloc(1, sizeof(importer_ctx));
+  return ctx;
+}
+
+void importer_ctx_free(importer_ctx* ctx) {
+  free(ctx);
+}
+
+object* importer_load(const char* asset) {
+  importer_ctx ctx = { 0 };
+  return importer_load_ctx(&ctx, asset);
+}
+
+typedef struct {
+  const char* asset;
+  object* result;
+} load_job;
+
+static void* load_worker(void* arg) {
+  load_job* job = arg;
+  importer_ctx* ctx = importer_ctx_new();
+  job->result = importer_load_ctx(ctx, job->asset);
+  importer_ctx_free(ctx);
+  return NULL;
+}
+
+void importer_load_batch(const char** assets, object** out, int count) {
+  load_job jobs[IMPORTER_MAX_BATCH];
+  pthread_t threads[IMPORTER_MAX_BATCH];
+  assert(count <= IMPORTER_MAX_BATCH);
+
+  for (int i = 0; i < count; i++) {
+    jobs[i].asset = assets[i];
+    jobs[i].result = NULL;
+    if (pthread_create(&threads[i], NULL, load_worker, &jobs[i]) != 0) {
+      printf("[importer] cannot create loader thread\n");
+      exit(1);
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    pthread_join(threads[i], NULL);
+    out[i] = jobs[i].result;
+  }
+}
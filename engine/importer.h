@@ -7,6 +7,41 @@
 #include "data/frame.h"
 #include "data/animation.h"
 
+#define IMPORTER_MAX_THREADS 16
+#define IMPORTER_MAX_BATCH 16
+
+// bump when the layout of vertex, vertex_packed, vertex_skin, material or the
+// .smesh file changes (or what baking does to the meshes)
+#define IMPORTER_SMESH_VERSION 8
+// bump when the layout of frame, animation or the .sanim file changes (clips
+// are stored padded to POSE_LANES joints)
+#define IMPORTER_SANIM_VERSION 4
+
+// threads used to parse obj files (0 = one per cpu)
+extern int importer_threads;
+
+// for importer_bench: 0 parses the text files even when fresh .smesh and
+// .sanim files exist, and importer_legacy parses obj and mtl files with the
+// fgets/sscanf loader the tokenizer replaced (it never loads baked files)
+extern int importer_baked;
+extern int importer_legacy;
+
+// parse state of one load, a context must not be shared between threads
+typedef struct importer_ctx importer_ctx;
+
+importer_ctx* importer_ctx_new();
+void importer_ctx_free(importer_ctx* ctx);
+object* importer_load_ctx(importer_ctx* ctx, const char* asset);
+
 object* importer_load(const char *filename);
 
+// parses the obj (and skl/anm), reorders the meshes for the vertex caches
+// and writes out_dir/asset/asset.smesh (and asset.sanim), loaded from
+// assets/ instead of the text files while those are unchanged. out_dir ends
+// with '/' and its asset directory must exist
+int importer_bake(const char* asset, const char* out_dir);
+
+// loads every asset on its own thread, objects are not uploaded to the gpu
+void importer_load_batch(const char** assets, object** out, int count);
+
 #endif
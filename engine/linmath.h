@@ -646,7 +646,7 @@ static inline void quat_from_mat4(quat q, mat4 M)
   }
 }
 
-static inline void quat_slerp(quat r, quat from, quat to, float amount) {
+static inline void quat_slerp(quat r, quat const from, quat const to, float amount) {
   float scale0, scale1;
   float	afto1[4];
   float cosom = from[0] * to[0] + from[1] * to[1] + from[2] * to[2] + from[3] * to[3];
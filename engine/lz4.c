@@ -0,0 +1,174 @@
+#include "lz4.h"
+
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 16
+
+// the format wants the last 5 bytes as literals and no match starting in the last 12
+#define LAST_LITERALS 5
+#define MATCH_LIMIT 12
+
+static inline unsigned read32(const unsigned char* p) {
+  unsigned v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+static inline unsigned hash4(unsigned v) {
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// length above the 4 bit token field, as a run of 255s and a remainder
+static unsigned char* write_length(unsigned char* op, int len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = len;
+  return op;
+}
+
+static const unsigned char* read_length(const unsigned char* ip, const unsigned char* end, size_t* len) {
+  unsigned char b;
+  do {
+    if (ip >= end) return NULL;
+    b = *ip++;
+    *len += b;
+  } while (b == 255);
+  return ip;
+}
+
+int lz4_bound(int size) {
+  return size + size / 255 + 16;
+}
+
+int lz4_compress(const char* src, int size, char* dst, int capacity) {
+  const unsigned char* in = (const unsigned char*)src;
+  const unsigned char* ip = in;
+  const unsigned char* anchor = in;
+  const unsigned char* end = in + size;
+  unsigned char* op = (unsigned char*)dst;
+  unsigned char* op_end = op + capacity;
+
+  // last position each 4 byte sequence was seen at
+  int* table = calloc(1 << HASH_BITS, sizeof(int));
+
+  if (size > MATCH_LIMIT) {
+    const unsigned char* match_limit = end - MATCH_LIMIT;
+    const unsigned char* match_end = end - LAST_LITERALS;
+    int misses = 0;
+
+    while (ip < match_limit) {
+      unsigned h = hash4(read32(ip));
+      const unsigned char* ref = in + table[h];
+      table[h] = ip - in;
+
+      if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != read32(ip)) {
+        // step faster through data that does not compress
+        ip += 1 + (misses++ >> 6);
+        continue;
+      }
+      misses = 0;
+
+      const unsigned char* mp = ip + MIN_MATCH;
+      const unsigned char* rp = ref + MIN_MATCH;
+      while (mp < match_end && *mp == *rp) {
+        mp++;
+        rp++;
+      }
+
+      int literals = ip - anchor;
+      int match = mp - ip - MIN_MATCH;
+      if (op + 1 + literals + literals / 255 + 1 + 2 + match / 255 + 1 > op_end) {
+        free(table);
+        return 0;
+      }
+
+      *op++ = (literals >= 15 ? 15 : literals) << 4 | (match >= 15 ? 15 : match);
+      if (literals >= 15) op = write_length(op, literals - 15);
+      memcpy(op, anchor, literals);
+      op += literals;
+
+      int offset = ip - ref;
+      *op++ = offset & 255;
+      *op++ = offset >> 8;
+      if (match >= 15) op = write_length(op, match - 15);
+
+      ip = mp;
+      anchor = ip;
+    }
+  }
+
+  // last literals
+  int literals = end - anchor;
+  if (op + 1 + literals + literals / 255 + 1 > op_end) {
+    free(table);
+    return 0;
+  }
+
+  *op++ = (literals >= 15 ? 15 : literals) << 4;
+  if (literals >= 15) op = write_length(op, literals - 15);
+  memcpy(op, anchor, literals);
+  op += literals;
+
+  free(table);
+  return op - (unsigned char*)dst;
+}
+
+int lz4_decompress(const char* src, int size, char* dst, int raw_size) {
+  const unsigned char* ip = (const unsigned char*)src;
+  const unsigned char* ip_end = ip + size;
+  unsigned char* out = (unsigned char*)dst;
+  unsigned char* op = out;
+  unsigned char* op_end = out + raw_size;
+
+  while (ip < ip_end) {
+    unsigned token = *ip++;
+
+    // literals
+    size_t literals = token >> 4;
+    if (literals == 15 && (ip = read_length(ip, ip_end, &literals)) == NULL) return -1;
+    if (literals > (size_t)(ip_end - ip) || literals > (size_t)(op_end - op)) return -1;
+    if (literals <= 16 && ip_end - ip >= 16 && op_end - op >= 16) {
+      // short run, copy a fixed 16 bytes
+      memcpy(op, ip, 16);
+    } else {
+      memcpy(op, ip, literals);
+    }
+    op += literals;
+    ip += literals;
+
+    // the last sequence has no match
+    if (ip == ip_end) break;
+
+    // match
+    if (ip_end - ip < 2) return -1;
+    size_t offset = ip[0] | ip[1] << 8;
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - out)) return -1;
+
+    size_t match = token & 15;
+    if (match == 15 && (ip = read_length(ip, ip_end, &match)) == NULL) return -1;
+    match += MIN_MATCH;
+    if (match > (size_t)(op_end - op)) return -1;
+
+    const unsigned char* ref = op - offset;
+    if (offset >= 8 && (size_t)(op_end - op) >= match + 8) {
+      // 8 bytes at a time, may write past the match (overwritten by what follows)
+      unsigned char* target = op + match;
+      while (op < target) {
+        memcpy(op, ref, 8);
+        op += 8;
+        ref += 8;
+      }
+      op = target;
+    } else {
+      // overlapping copy repeats the last 'offset' bytes
+      for (size_t i = 0; i < match; i++) {
+        *op++ = *ref++;
+      }
+    }
+  }
+
+  return op == op_end ? raw_size : -1;
+}
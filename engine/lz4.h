@@ -0,0 +1,17 @@
+#ifndef lz4_h
+#define lz4_h
+
+#include "engine.h"
+
+// lz4 block format (no frame header, sizes are stored by the caller)
+
+// worst case compressed size of 'size' bytes
+int lz4_bound(int size);
+
+// returns the compressed size, 0 if it does not fit in 'capacity'
+int lz4_compress(const char* src, int size, char* dst, int capacity);
+
+// returns 'raw_size', -1 if the block is corrupt or does not decode to 'raw_size' bytes
+int lz4_decompress(const char* src, int size, char* dst, int raw_size);
+
+#endif
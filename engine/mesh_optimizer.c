@@ -0,0 +1,339 @@
+#include "mesh_optimizer.h"
+
+int mesh_optimizer_overdraw = 0;
+
+/* fifo cache simulation: a vertex stays cached until cache size misses
+   happened after its own, so only the time of its last miss is kept */
+typedef struct {
+  int* stamps;
+  int time;
+} fifo_cache;
+
+static void cache_init(fifo_cache* c, int vertex_count) {
+  c->stamps = malloc((vertex_count > 0 ? vertex_count : 1) * sizeof(int));
+  for (int i = 0; i < vertex_count; i++) {
+    c->stamps[i] = -MESH_OPTIMIZER_CACHE_SIZE;
+  }
+  c->time = 0;
+}
+
+// empties the cache without touching every vertex
+static void cache_flush(fifo_cache* c) {
+  c->time += MESH_OPTIMIZER_CACHE_SIZE;
+}
+
+// 1 if v was not in the cache (and loads it)
+static int cache_miss(fifo_cache* c, GLuint v) {
+  if (c->time - c->stamps[v] < MESH_OPTIMIZER_CACHE_SIZE) {
+    return 0;
+  }
+  c->stamps[v] = c->time++;
+  return 1;
+}
+
+static int triangle_misses(fifo_cache* c, const GLuint* t) {
+  return cache_miss(c, t[0]) + cache_miss(c, t[1]) + cache_miss(c, t[2]);
+}
+
+/* tipsify (sander, nehab and barczak 2007): fans around a vertex, then
+   moves to the neighbour that will still be in the cache once its own fan
+   is emitted, falling back to recently used vertices and then to the
+   input order when the fan runs into a dead end */
+static void tipsify(const GLuint* in, int triangle_count, int vertex_count, GLuint* out) {
+  int index_count = triangle_count * 3;
+  int k = MESH_OPTIMIZER_CACHE_SIZE;
+
+  // triangles around each vertex
+  int* offsets = calloc(vertex_count + 1, sizeof(int));
+  int* adjacency = malloc(index_count * sizeof(int));
+  int* live = malloc(vertex_count * sizeof(int));
+  for (int i = 0; i < index_count; i++) {
+    offsets[in[i] + 1]++;
+  }
+  for (int v = 0; v < vertex_count; v++) {
+    live[v] = offsets[v + 1];
+    offsets[v + 1] += offsets[v];
+  }
+  int* fill = malloc((vertex_count > 0 ? vertex_count : 1) * sizeof(int));
+  memcpy(fill, offsets, vertex_count * sizeof(int));
+  for (int i = 0; i < index_count; i++) {
+    adjacency[fill[in[i]]++] = i / 3;
+  }
+  free(fill);
+
+  int* stamps = calloc(vertex_count, sizeof(int));
+  char* emitted = calloc(triangle_count, 1);
+  int* dead_ends = malloc(index_count * sizeof(int));
+  int* candidates = malloc(index_count * sizeof(int));
+  int dead_end_count = 0;
+
+  int time = k + 1;
+  int cursor = 0;
+  int out_count = 0;
+  int fan = in[0];
+
+  while (fan >= 0) {
+    // emit the live triangles around the fanning vertex
+    int candidate_count = 0;
+    for (int a = offsets[fan]; a < offsets[fan + 1]; a++) {
+      int t = adjacency[a];
+      if (emitted[t]) continue;
+
+      for (int c = 0; c < 3; c++) {
+        GLuint v = in[t * 3 + c];
+        out[out_count++] = v;
+        dead_ends[dead_end_count++] = v;
+        candidates[candidate_count++] = v;
+        live[v]--;
+        if (time - stamps[v] > k) {
+          stamps[v] = time++;
+        }
+      }
+      emitted[t] = 1;
+    }
+
+    // best neighbour: the one whose fan fits in the cache and entered it first
+    int next = -1, best = -1;
+    for (int i = 0; i < candidate_count; i++) {
+      int v = candidates[i];
+      if (live[v] == 0) continue;
+
+      int priority = 0;
+      if (time - stamps[v] + 2 * live[v] <= k) {
+        priority = time - stamps[v];
+      }
+      if (priority > best) {
+        best = priority;
+        next = v;
+      }
+    }
+
+    // dead end: most recent vertex with triangles left, then the input order
+    while (next < 0 && dead_end_count > 0) {
+      int v = dead_ends[--dead_end_count];
+      if (live[v] > 0) next = v;
+    }
+    while (next < 0 && cursor < vertex_count) {
+      if (live[cursor] > 0) next = cursor;
+      cursor++;
+    }
+
+    fan = next;
+  }
+
+  free(offsets);
+  free(adjacency);
+  free(live);
+  free(stamps);
+  free(emitted);
+  free(dead_ends);
+  free(candidates);
+}
+
+typedef struct {
+  int first;  // first triangle
+  int count;
+  float key;
+} cluster;
+
+static int compare_clusters(const void* a, const void* b) {
+  const cluster* ca = a;
+  const cluster* cb = b;
+  if (ca->key != cb->key) return ca->key < cb->key ? 1 : -1;
+  return ca->first - cb->first;
+}
+
+static void triangle_geometry(const vertex* vertices, const GLuint* t, vec3 centroid, vec3 normal) {
+  const vertex* a = &vertices[t[0]];
+  const vertex* b = &vertices[t[1]];
+  const vertex* c = &vertices[t[2]];
+  vec3 edge1 = { b->x - a->x, b->y - a->y, b->z - a->z };
+  vec3 edge2 = { c->x - a->x, c->y - a->y, c->z - a->z };
+
+  // twice the area, length of the cross product
+  vec3_mul_cross(normal, edge1, edge2);
+  centroid[0] = (a->x + b->x + c->x) / 3.0f;
+  centroid[1] = (a->y + b->y + c->y) / 3.0f;
+  centroid[2] = (a->z + b->z + c->z) / 3.0f;
+}
+
+/* overdraw (sander et al. 2007): the cache ordered triangles are cut where
+   the cache starts cold anyway, and again wherever a run already reached
+   the hit rate of its whole cut. runs facing away from the center of the
+   mesh tend to hide the others, so they are drawn first */
+static void sort_clusters(const vertex* vertices, const GLuint* in, int triangle_count, int vertex_count, GLuint* out) {
+  cluster* clusters = malloc(triangle_count * sizeof(cluster));
+  int cluster_count = 0;
+
+  fifo_cache cache;
+  cache_init(&cache, vertex_count);
+
+  // hard boundaries: all three vertices missed
+  int* hard = malloc((triangle_count + 1) * sizeof(int));
+  int hard_count = 0;
+  for (int t = 0; t < triangle_count; t++) {
+    if (triangle_misses(&cache, &in[t * 3]) == 3) {
+      hard[hard_count++] = t;
+    }
+  }
+  hard[hard_count] = triangle_count;
+
+  // soft boundaries inside each of them
+  for (int h = 0; h < hard_count; h++) {
+    int first = hard[h], end = hard[h + 1];
+
+    cache_flush(&cache);
+    int misses = 0;
+    for (int t = first; t < end; t++) {
+      misses += triangle_misses(&cache, &in[t * 3]);
+    }
+    float acmr = (float)misses / (end - first);
+
+    cache_flush(&cache);
+    int start = first;
+    misses = 0;
+    for (int t = first; t < end; t++) {
+      misses += triangle_misses(&cache, &in[t * 3]);
+      if (t + 1 < end && misses <= MESH_OPTIMIZER_OVERDRAW_THRESHOLD * acmr * (t + 1 - start)) {
+        clusters[cluster_count++] = (cluster){ start, t + 1 - start, 0.0f };
+        cache_flush(&cache);
+        start = t + 1;
+        misses = 0;
+      }
+    }
+    clusters[cluster_count++] = (cluster){ start, end - start, 0.0f };
+  }
+
+  free(hard);
+  free(cache.stamps);
+
+  // area weighted centroid of the mesh
+  vec3 center = { 0.0f, 0.0f, 0.0f };
+  float area = 0.0f;
+  for (int t = 0; t < triangle_count; t++) {
+    vec3 centroid, normal;
+    triangle_geometry(vertices, &in[t * 3], centroid, normal);
+    float a = vec3_len(normal);
+    vec3_scale(centroid, centroid, a);
+    vec3_add(center, center, centroid);
+    area += a;
+  }
+  if (area > 0.0f) {
+    vec3_scale(center, center, 1.0f / area);
+  }
+
+  for (int i = 0; i < cluster_count; i++) {
+    cluster* c = &clusters[i];
+    vec3 cluster_center = { 0.0f, 0.0f, 0.0f };
+    vec3 cluster_normal = { 0.0f, 0.0f, 0.0f };
+    float cluster_area = 0.0f;
+
+    for (int t = c->first; t < c->first + c->count; t++) {
+      vec3 centroid, normal;
+      triangle_geometry(vertices, &in[t * 3], centroid, normal);
+      float a = vec3_len(normal);
+      vec3_scale(centroid, centroid, a);
+      vec3_add(cluster_center, cluster_center, centroid);
+      vec3_add(cluster_normal, cluster_normal, normal);
+      cluster_area += a;
+    }
+
+    float length = vec3_len(cluster_normal);
+    if (cluster_area > 0.0f && length > 0.0f) {
+      vec3_scale(cluster_center, cluster_center, 1.0f / cluster_area);
+      vec3_sub(cluster_center, cluster_center, center);
+      c->key = vec3_mul_inner(cluster_center, cluster_normal) / length;
+    }
+  }
+
+  qsort(clusters, cluster_count, sizeof(cluster), compare_clusters);
+
+  int out_count = 0;
+  for (int i = 0; i < cluster_count; i++) {
+    memcpy(&out[out_count], &in[clusters[i].first * 3], clusters[i].count * 3 * sizeof(GLuint));
+    out_count += clusters[i].count * 3;
+  }
+
+  free(clusters);
+}
+
+// renumbers vertices in the order the indices first use them, unused ones last
+static void reorder_vertices(mesh* m) {
+  int* remap = malloc(m->num_vertices * sizeof(int));
+  for (GLuint v = 0; v < m->num_vertices; v++) {
+    remap[v] = -1;
+  }
+
+  int next = 0;
+  for (GLuint i = 0; i < m->num_indices; i++) {
+    if (remap[m->indices[i]] < 0) {
+      remap[m->indices[i]] = next++;
+    }
+  }
+  for (GLuint v = 0; v < m->num_vertices; v++) {
+    if (remap[v] < 0) {
+      remap[v] = next++;
+    }
+  }
+
+  vertex* copy = malloc(m->num_vertices * sizeof(vertex));
+  for (GLuint v = 0; v < m->num_vertices; v++) {
+    copy[remap[v]] = m->vertices[v];
+  }
+  memcpy(m->vertices, copy, m->num_vertices * sizeof(vertex));
+  for (GLuint i = 0; i < m->num_indices; i++) {
+    m->indices[i] = remap[m->indices[i]];
+  }
+
+  free(copy);
+  free(remap);
+}
+
+void mesh_optimizer_run(mesh* m) {
+  int triangle_count = m->num_indices / 3;
+  if (triangle_count == 0 || m->num_vertices == 0) {
+    return;
+  }
+
+  GLuint* ordered = malloc(triangle_count * 3 * sizeof(GLuint));
+  tipsify(m->indices, triangle_count, m->num_vertices, ordered);
+  if (mesh_optimizer_overdraw) {
+    sort_clusters(m->vertices, ordered, triangle_count, m->num_vertices, m->indices);
+  } else {
+    memcpy(m->indices, ordered, triangle_count * 3 * sizeof(GLuint));
+  }
+  free(ordered);
+
+  reorder_vertices(m);
+}
+
+void mesh_optimizer_order(GLuint* indices, int index_count, int vertex_count) {
+  int triangle_count = index_count / 3;
+  if (triangle_count == 0 || vertex_count == 0) {
+    return;
+  }
+
+  GLuint* ordered = malloc(triangle_count * 3 * sizeof(GLuint));
+  tipsify(indices, triangle_count, vertex_count, ordered);
+  memcpy(indices, ordered, triangle_count * 3 * sizeof(GLuint));
+  free(ordered);
+}
+
+void mesh_optimizer_stats(const mesh* m, float* acmr, float* atvr) {
+  int triangle_count = m->num_indices / 3;
+  *acmr = *atvr = 0.0f;
+  if (triangle_count == 0 || m->num_vertices == 0) {
+    return;
+  }
+
+  fifo_cache cache;
+  cache_init(&cache, m->num_vertices);
+  int misses = 0;
+  for (int t = 0; t < triangle_count; t++) {
+    misses += triangle_misses(&cache, &m->indices[t * 3]);
+  }
+  free(cache.stamps);
+
+  *acmr = (float)misses / triangle_count;
+  *atvr = (float)misses / m->num_vertices;
+}
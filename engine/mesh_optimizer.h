@@ -0,0 +1,31 @@
+#ifndef mesh_optimizer_h
+#define mesh_optimizer_h
+
+#include "engine.h"
+#include "data/mesh.h"
+
+// fifo post-transform cache the triangle order is tuned for and the
+// statistics simulate
+#define MESH_OPTIMIZER_CACHE_SIZE 16
+
+// clusters may lose this much of the cache hit rate to be sorted for overdraw
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f
+
+// also sort runs of triangles so outward facing parts are drawn first
+// (off by default, costs some of the cache hits)
+extern int mesh_optimizer_overdraw;
+
+/* reorders the triangles of a mesh for the post-transform cache (tipsify),
+   optionally sorts them for overdraw, and finally renumbers the vertices in
+   the order they are first used so fetches walk the vertex buffer forward.
+   the mesh keeps its ranges */
+void mesh_optimizer_run(mesh* m);
+
+// reorders only the triangles of an index list (tipsify), for index ranges
+// sharing vertices that are already laid out
+void mesh_optimizer_order(GLuint* indices, int index_count, int vertex_count);
+
+// average cache misses per triangle and per vertex of the current order
+void mesh_optimizer_stats(const mesh* m, float* acmr, float* atvr);
+
+#endif
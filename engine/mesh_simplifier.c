@@ -0,0 +1,403 @@
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+
+// sum of weighted squared distances to planes, as a symmetric 4x4 matrix
+typedef struct {
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+  double weight;
+} quadric;
+
+static void quadric_add_plane(quadric* q, const vec3 n, float d, float w) {
+  q->a2 += w * n[0] * n[0];
+  q->ab += w * n[0] * n[1];
+  q->ac += w * n[0] * n[2];
+  q->ad += w * n[0] * d;
+  q->b2 += w * n[1] * n[1];
+  q->bc += w * n[1] * n[2];
+  q->bd += w * n[1] * d;
+  q->c2 += w * n[2] * n[2];
+  q->cd += w * n[2] * d;
+  q->d2 += w * d * d;
+  q->weight += w;
+}
+
+static void quadric_add(quadric* q, const quadric* r) {
+  q->a2 += r->a2; q->ab += r->ab; q->ac += r->ac; q->ad += r->ad;
+  q->b2 += r->b2; q->bc += r->bc; q->bd += r->bd;
+  q->c2 += r->c2; q->cd += r->cd;
+  q->d2 += r->d2;
+  q->weight += r->weight;
+}
+
+// mean squared distance of p to the planes of q and r
+static float quadric_error(const quadric* q, const quadric* r, const vertex* p) {
+  quadric s = *q;
+  quadric_add(&s, r);
+  double x = p->x, y = p->y, z = p->z;
+  double e = s.a2 * x * x + s.b2 * y * y + s.c2 * z * z
+    + 2.0 * (s.ab * x * y + s.ac * x * z + s.bc * y * z + s.ad * x + s.bd * y + s.cd * z)
+    + s.d2;
+  if (s.weight > 0.0) e /= s.weight;
+  return e > 0.0 ? (float)e : 0.0f;
+}
+
+static void face_normal(const vertex* a, const vertex* b, const vertex* c, vec3 n) {
+  vec3 edge1 = { b->x - a->x, b->y - a->y, b->z - a->z };
+  vec3 edge2 = { c->x - a->x, c->y - a->y, c->z - a->z };
+  vec3_mul_cross(n, edge1, edge2);
+}
+
+/* vertices at the same position (split by uvs or normals) form a group,
+   named after its first vertex, and are linked in a ring */
+static void build_groups(const vertex* vertices, int vertex_count, int* group, int* next_wedge) {
+  int capacity = 16;
+  while (capacity < vertex_count * 2) capacity *= 2;
+  int* table = malloc(capacity * sizeof(int));
+  for (int i = 0; i < capacity; i++) {
+    table[i] = -1;
+  }
+
+  for (int v = 0; v < vertex_count; v++) {
+    unsigned int h = 2166136261u;
+    const unsigned char* bytes = (const unsigned char*)&vertices[v].x;
+    for (int i = 0; i < 3 * (int)sizeof(GLfloat); i++) {
+      h = (h ^ bytes[i]) * 16777619u;
+    }
+
+    unsigned int slot = h & (capacity - 1);
+    while (table[slot] >= 0 && memcmp(&vertices[table[slot]].x, &vertices[v].x, 3 * sizeof(GLfloat)) != 0) {
+      slot = (slot + 1) & (capacity - 1);
+    }
+
+    if (table[slot] < 0) {
+      table[slot] = v;
+      group[v] = v;
+      next_wedge[v] = v;
+    } else {
+      int first = table[slot];
+      group[v] = first;
+      next_wedge[v] = next_wedge[first];
+      next_wedge[first] = v;
+    }
+  }
+
+  free(table);
+}
+
+static int compare_edges(const void* a, const void* b) {
+  unsigned long long ea = *(const unsigned long long*)a;
+  unsigned long long eb = *(const unsigned long long*)b;
+  return ea < eb ? -1 : ea > eb;
+}
+
+enum {
+  GROUP_INTERIOR,
+  GROUP_BORDER,   // on exactly two open edges, slides along them
+  GROUP_LOCKED    // border corner or non manifold, never moves
+};
+
+/* collects the edges between groups, sorted, with the number of triangles
+   on each, and classifies the groups by the edges around them */
+static int classify_edges(const GLuint* indices, int index_count, const int* group,
+  unsigned long long* edges, int* counts, int* border_edges, char* kind) {
+  int edge_count = 0;
+  for (int i = 0; i < index_count; i += 3) {
+    for (int k = 0; k < 3; k++) {
+      unsigned long long a = group[indices[i + k]];
+      unsigned long long b = group[indices[i + (k + 1) % 3]];
+      if (a == b) continue;
+      edges[edge_count++] = a < b ? (a << 32) | b : (b << 32) | a;
+    }
+  }
+  qsort(edges, edge_count, sizeof(unsigned long long), compare_edges);
+
+  int unique = 0;
+  for (int i = 0; i < edge_count;) {
+    int j = i;
+    while (j < edge_count && edges[j] == edges[i]) j++;
+    edges[unique] = edges[i];
+    counts[unique++] = j - i;
+    i = j;
+  }
+
+  for (int i = 0; i < unique; i++) {
+    int a = edges[i] >> 32, b = edges[i] & 0xffffffffULL;
+    border_edges[a] = border_edges[b] = 0;
+    kind[a] = kind[b] = GROUP_INTERIOR;
+  }
+  for (int i = 0; i < unique; i++) {
+    int a = edges[i] >> 32, b = edges[i] & 0xffffffffULL;
+    if (counts[i] > 2) {
+      kind[a] = kind[b] = GROUP_LOCKED;
+    } else if (counts[i] == 1) {
+      border_edges[a]++;
+      border_edges[b]++;
+    }
+  }
+  for (int i = 0; i < unique; i++) {
+    int ends[2] = { edges[i] >> 32, edges[i] & 0xffffffffULL };
+    for (int k = 0; k < 2; k++) {
+      int g = ends[k];
+      if (kind[g] == GROUP_LOCKED || border_edges[g] == 0) continue;
+      kind[g] = border_edges[g] == 2 ? GROUP_BORDER : GROUP_LOCKED;
+    }
+  }
+
+  return unique;
+}
+
+static int is_border_edge(const unsigned long long* edges, const int* counts, int edge_count, int a, int b) {
+  unsigned long long key = a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+  const unsigned long long* found = bsearch(&key, edges, edge_count, sizeof(unsigned long long), compare_edges);
+  return found != NULL && counts[found - edges] == 1;
+}
+
+typedef struct {
+  int from, to;   // groups
+  float cost;
+} collapse;
+
+static int compare_collapses(const void* a, const void* b) {
+  const collapse* ca = a;
+  const collapse* cb = b;
+  return ca->cost < cb->cost ? -1 : ca->cost > cb->cost;
+}
+
+int mesh_simplify(const vertex* vertices, int vertex_count, const GLuint* indices, int index_count,
+  int target_index_count, float max_error, GLuint* out, float* error) {
+  index_count -= index_count % 3;
+  memcpy(out, indices, index_count * sizeof(GLuint));
+  *error = 0.0f;
+  if (index_count <= target_index_count || vertex_count == 0) {
+    return index_count;
+  }
+
+  int* group = malloc(vertex_count * sizeof(int));
+  int* next_wedge = malloc(vertex_count * sizeof(int));
+  build_groups(vertices, vertex_count, group, next_wedge);
+
+  unsigned long long* edges = malloc(index_count * sizeof(unsigned long long));
+  int* counts = malloc(index_count * sizeof(int));
+  int* border_edges = malloc(vertex_count * sizeof(int));
+  char* kind = malloc(vertex_count);
+
+  // planes of the faces around each group, weighted by area
+  quadric* quadrics = calloc(vertex_count, sizeof(quadric));
+  for (int i = 0; i < index_count; i += 3) {
+    const vertex* a = &vertices[out[i]];
+    vec3 n;
+    face_normal(a, &vertices[out[i + 1]], &vertices[out[i + 2]], n);
+    float area = vec3_len(n);
+    if (area <= 0.0f) continue;
+
+    vec3_scale(n, n, 1.0f / area);
+    float d = -(n[0] * a->x + n[1] * a->y + n[2] * a->z);
+    for (int k = 0; k < 3; k++) {
+      quadric_add_plane(&quadrics[group[out[i + k]]], n, d, area);
+    }
+  }
+
+  // open edges keep their shape with a plane through them, across the face
+  int edge_count = classify_edges(out, index_count, group, edges, counts, border_edges, kind);
+  for (int i = 0; i < index_count; i++) {
+    int a = group[out[i]];
+    int b = group[out[i - i % 3 + (i + 1) % 3]];
+    int c = group[out[i - i % 3 + (i + 2) % 3]];
+    if (a == b || !is_border_edge(edges, counts, edge_count, a, b)) continue;
+
+    vec3 n, side;
+    vec3 edge = { vertices[b].x - vertices[a].x, vertices[b].y - vertices[a].y, vertices[b].z - vertices[a].z };
+    face_normal(&vertices[a], &vertices[b], &vertices[c], n);
+    vec3_mul_cross(side, edge, n);
+    float length = vec3_len(side);
+    if (length <= 0.0f) continue;
+
+    vec3_scale(side, side, 1.0f / length);
+    float d = -(side[0] * vertices[a].x + side[1] * vertices[a].y + side[2] * vertices[a].z);
+    float weight = vec3_mul_inner(edge, edge);
+    quadric_add_plane(&quadrics[a], side, d, weight);
+    quadric_add_plane(&quadrics[b], side, d, weight);
+  }
+
+  int* offsets = malloc((vertex_count + 1) * sizeof(int));
+  int* adjacency = malloc(index_count * sizeof(int));
+  int* remap = malloc(vertex_count * sizeof(int));
+  int* partner = malloc(vertex_count * sizeof(int));
+  char* touched = malloc(vertex_count);
+  collapse* collapses = malloc(index_count * sizeof(collapse));
+  float max_cost = max_error * max_error;
+  float worst = 0.0f;
+
+  while (index_count > target_index_count) {
+    // triangles around each vertex
+    memset(offsets, 0, (vertex_count + 1) * sizeof(int));
+    for (int i = 0; i < index_count; i++) {
+      offsets[out[i] + 1]++;
+    }
+    for (int v = 0; v < vertex_count; v++) {
+      offsets[v + 1] += offsets[v];
+    }
+    for (int i = 0; i < index_count; i++) {
+      adjacency[offsets[out[i]]++] = i / 3;
+    }
+    for (int v = vertex_count; v > 0; v--) {
+      offsets[v] = offsets[v - 1];
+    }
+    offsets[0] = 0;
+
+    // the cheaper direction of every edge, border groups only along the border
+    edge_count = classify_edges(out, index_count, group, edges, counts, border_edges, kind);
+    int collapse_count = 0;
+    for (int i = 0; i < edge_count; i++) {
+      int a = edges[i] >> 32, b = edges[i] & 0xffffffffULL;
+      int border = counts[i] == 1;
+      if (counts[i] > 2) continue;
+
+      int a_moves = kind[a] == GROUP_INTERIOR || (kind[a] == GROUP_BORDER && border);
+      int b_moves = kind[b] == GROUP_INTERIOR || (kind[b] == GROUP_BORDER && border);
+      float ab = a_moves ? quadric_error(&quadrics[a], &quadrics[b], &vertices[b]) : FLT_MAX;
+      float ba = b_moves ? quadric_error(&quadrics[a], &quadrics[b], &vertices[a]) : FLT_MAX;
+      if (ab == FLT_MAX && ba == FLT_MAX) continue;
+
+      collapses[collapse_count++] = ab <= ba ? (collapse){ a, b, ab } : (collapse){ b, a, ba };
+    }
+    qsort(collapses, collapse_count, sizeof(collapse), compare_collapses);
+
+    for (int v = 0; v < vertex_count; v++) {
+      remap[v] = v;
+    }
+    memset(touched, 0, vertex_count);
+
+    int removed = 0, applied = 0;
+    for (int c = 0; c < collapse_count && index_count - removed > target_index_count; c++) {
+      collapse* cl = &collapses[c];
+      if (cl->cost > max_cost) break;
+      if (touched[cl->from] || touched[cl->to]) continue;
+
+      // every vertex of the group needs a neighbour in the target group to
+      // move onto, or a seam would open
+      int valid = 1, shared = 0;
+      int w = cl->from;
+      do {
+        partner[w] = -1;
+        for (int a = offsets[w]; a < offsets[w + 1] && partner[w] < 0; a++) {
+          const GLuint* t = &out[adjacency[a] * 3];
+          for (int k = 0; k < 3; k++) {
+            if (group[t[k]] == cl->to) partner[w] = t[k];
+          }
+        }
+        if (partner[w] < 0) valid = 0;
+        w = next_wedge[w];
+      } while (w != cl->from && valid);
+      if (!valid) continue;
+
+      // the remaining triangles must not turn over
+      w = cl->from;
+      do {
+        for (int a = offsets[w]; a < offsets[w + 1] && valid; a++) {
+          const GLuint* t = &out[adjacency[a] * 3];
+          const vertex* before[3];
+          const vertex* after[3];
+          int collapsing = 0;
+          for (int k = 0; k < 3; k++) {
+            before[k] = &vertices[group[t[k]]];
+            after[k] = group[t[k]] == cl->from ? &vertices[cl->to] : before[k];
+            if (group[t[k]] == cl->to) collapsing = 1;
+          }
+          if (collapsing) {
+            shared++;
+            continue;
+          }
+
+          vec3 n0, n1;
+          face_normal(before[0], before[1], before[2], n0);
+          face_normal(after[0], after[1], after[2], n1);
+          if (vec3_mul_inner(n0, n1) <= 0.0f) valid = 0;
+        }
+        w = next_wedge[w];
+      } while (w != cl->from && valid);
+      if (!valid) continue;
+
+      // collapse, and keep this pass away from the triangles that changed
+      w = cl->from;
+      do {
+        remap[w] = partner[w];
+        for (int a = offsets[w]; a < offsets[w + 1]; a++) {
+          const GLuint* t = &out[adjacency[a] * 3];
+          for (int k = 0; k < 3; k++) {
+            touched[group[t[k]]] = 1;
+          }
+        }
+        w = next_wedge[w];
+      } while (w != cl->from);
+
+      quadric_add(&quadrics[cl->to], &quadrics[cl->from]);
+      removed += shared * 3;
+      applied++;
+      if (cl->cost > worst) worst = cl->cost;
+    }
+
+    if (applied == 0) break;
+
+    // drop the triangles that lost an edge
+    int count = 0;
+    for (int i = 0; i < index_count; i += 3) {
+      GLuint a = remap[out[i]], b = remap[out[i + 1]], c = remap[out[i + 2]];
+      if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c]) continue;
+      out[count++] = a;
+      out[count++] = b;
+      out[count++] = c;
+    }
+    index_count = count;
+  }
+
+  free(group);
+  free(next_wedge);
+  free(edges);
+  free(counts);
+  free(border_edges);
+  free(kind);
+  free(quadrics);
+  free(offsets);
+  free(adjacency);
+  free(remap);
+  free(partner);
+  free(touched);
+  free(collapses);
+
+  *error = sqrtf(worst);
+  return index_count;
+}
+
+int mesh_simplifier_build_lods(mesh* m, GLuint* lods) {
+  mesh_init_lods(m);
+  mesh_compute_bounds(m);
+
+  float max_error = MESH_SIMPLIFIER_MAX_ERROR * m->radius;
+  GLuint* level = malloc((m->num_indices > 0 ? m->num_indices : 1) * sizeof(GLuint));
+  int used = 0;
+  float target = m->num_indices;
+
+  // every level is simplified from the whole mesh, so its error is its own
+  while (m->num_lods < MESH_MAX_LODS) {
+    target *= MESH_SIMPLIFIER_RATIO;
+    float error;
+    int count = mesh_simplify(m->vertices, m->num_vertices, m->indices, m->num_indices, (int)target, max_error, level, &error);
+
+    // not worth a level (stuck on locked vertices or the error limit)
+    GLuint previous = m->lod_indices[m->num_lods - 1];
+    if (count > previous * 0.75f || used + count > (int)m->num_indices) {
+      break;
+    }
+
+    mesh_optimizer_order(level, count, m->num_vertices);
+    memcpy(lods + used, level, count * sizeof(GLuint));
+    m->lod_indices[m->num_lods] = count;
+    m->lod_error[m->num_lods] = error;
+    m->num_lods++;
+    used += count;
+  }
+
+  free(level);
+  return used;
+}
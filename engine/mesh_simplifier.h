@@ -0,0 +1,28 @@
+#ifndef mesh_simplifier_h
+#define mesh_simplifier_h
+
+#include "engine.h"
+#include "data/mesh.h"
+
+// each level aims at this fraction of the triangles of the previous one
+#define MESH_SIMPLIFIER_RATIO 0.5f
+
+// levels stop once they would move the surface further than this, relative
+// to the mesh's bounding radius
+#define MESH_SIMPLIFIER_MAX_ERROR 0.05f
+
+/* quadric error simplification (garland and heckbert 1997) restricted to
+   the existing vertices: edges collapse into one of their ends, so every
+   level indexes the same vertex range. vertices on open borders only slide
+   along the border, vertices split along uv or normal seams only along the
+   seam, and border corners and non manifold vertices stay.
+   writes at most index_count indices to out and returns how many, error is
+   the largest distance a collapse moved the surface */
+int mesh_simplify(const vertex* vertices, int vertex_count, const GLuint* indices, int index_count,
+  int target_index_count, float max_error, GLuint* out, float* error);
+
+// fills the coarser levels of m (up to MESH_MAX_LODS) into lods, which has
+// room for num_indices indices, and returns how many it used
+int mesh_simplifier_build_lods(mesh* m, GLuint* lods);
+
+#endif
@@ -12,7 +12,8 @@ static vertex scale_vertex(float scale, vertex v) {
 }
 
 void physics_compute_aabb(object* object) {
-  aabb aabb;
+  // keeps the debug buffers of the box
+  aabb aabb = object->box;
 
   mesh* first_mesh = &object->meshes[0];
   vertex first_vertex = scale_vertex(object->scale, first_mesh->vertices[0]);
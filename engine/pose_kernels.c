@@ -0,0 +1,479 @@
+#include "pose_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define POSE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+/* every kernel comes in a scalar version and simd ones doing the same
+   arithmetic lane by lane. nothing is reassociated and there are no fused
+   multiply-adds or approximate reciprocals, so all of them give the same
+   bits and any can stand in for the others (as long as the compiler is not
+   allowed to fuse the scalar ones, which an -march with fma would do) */
+
+// scalar
+
+/* nlerp moves at an uneven speed along the arc, amount is bent towards the
+   slerp one first (kapoulkine, approximating slerp, 2015). d is the cosine
+   of the angle between the rotations. within 4e-4 of slerp at any angle,
+   much closer for neighbouring keyframes */
+static inline float slerp_correction(float d, float shape) {
+  float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+  float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+  return a * shape + b;
+}
+
+static void blend_scalar(float* out, int out_stride, const float* a, const float* b, int in_stride, float amount, int lanes) {
+  float keep = 1.0f - amount;
+
+  for (int c = POSE_X; c <= POSE_Z; c++) {
+    float* o = out + c * out_stride;
+    const float* ca = a + c * in_stride;
+    const float* cb = b + c * in_stride;
+    for (int i = 0; i < lanes; i++) {
+      o[i] = cb[i] * amount + ca[i] * keep;
+    }
+  }
+
+  const float* ax = a + POSE_QX * in_stride;
+  const float* ay = a + POSE_QY * in_stride;
+  const float* az = a + POSE_QZ * in_stride;
+  const float* aw = a + POSE_QW * in_stride;
+  const float* bx = b + POSE_QX * in_stride;
+  const float* by = b + POSE_QY * in_stride;
+  const float* bz = b + POSE_QZ * in_stride;
+  const float* bw = b + POSE_QW * in_stride;
+  float* ox = out + POSE_QX * out_stride;
+  float* oy = out + POSE_QY * out_stride;
+  float* oz = out + POSE_QZ * out_stride;
+  float* ow = out + POSE_QW * out_stride;
+
+  // terms of the slerp correction that only depend on amount
+  float shape = (amount - 0.5f) * (amount - 0.5f);
+  float bend = amount * (amount - 0.5f) * (amount - 1.0f);
+
+  for (int i = 0; i < lanes; i++) {
+    // b or -b, whichever is closer to a
+    float dot = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+    float d = fabsf(dot);
+
+    float t = amount + bend * slerp_correction(d, shape);
+    float t0 = 1.0f - t;
+    float t1 = dot < 0.0f ? -t : t;
+
+    float x = ax[i] * t0 + bx[i] * t1;
+    float y = ay[i] * t0 + by[i] * t1;
+    float z = az[i] * t0 + bz[i] * t1;
+    float w = aw[i] * t0 + bw[i] * t1;
+    float scale = 1.0f / sqrtf(x * x + y * y + z * z + w * w);
+
+    ox[i] = x * scale;
+    oy[i] = y * scale;
+    oz[i] = z * scale;
+    ow[i] = w * scale;
+  }
+}
+
+// same terms as mat4_from_quat
+static void rotations_scalar(float rot[9][MAX_JOINTS], const frame* f) {
+  int lanes = frame_lanes(f->joint_count);
+  for (int i = 0; i < lanes; i++) {
+    float a = f->joints[POSE_QW][i];
+    float b = f->joints[POSE_QX][i];
+    float c = f->joints[POSE_QY][i];
+    float d = f->joints[POSE_QZ][i];
+    float a2 = a * a;
+    float b2 = b * b;
+    float c2 = c * c;
+    float d2 = d * d;
+
+    rot[0][i] = a2 + b2 - c2 - d2;
+    rot[1][i] = 2.0f * (b * c + a * d);
+    rot[2][i] = 2.0f * (b * d - a * c);
+
+    rot[3][i] = 2.0f * (b * c - a * d);
+    rot[4][i] = a2 - b2 + c2 - d2;
+    rot[5][i] = 2.0f * (c * d + a * b);
+
+    rot[6][i] = 2.0f * (b * d + a * c);
+    rot[7][i] = 2.0f * (c * d - a * b);
+    rot[8][i] = a2 - b2 - c2 + d2;
+  }
+}
+
+static void local_transform(mat4 local, const frame* f, const float rot[9][MAX_JOINTS], int i) {
+  for (int c = 0; c < 3; c++) {
+    local[c][0] = rot[c * 3 + 0][i];
+    local[c][1] = rot[c * 3 + 1][i];
+    local[c][2] = rot[c * 3 + 2][i];
+    local[c][3] = 0.0f;
+  }
+  local[3][0] = f->joints[POSE_X][i];
+  local[3][1] = f->joints[POSE_Y][i];
+  local[3][2] = f->joints[POSE_Z][i];
+  local[3][3] = 1.0f;
+}
+
+// a * b for matrices whose last row is 0 0 0 1, r must not be a or b
+static void affine_mul(mat4 r, const mat4 a, const mat4 b) {
+  for (int c = 0; c < 4; c++) {
+    for (int row = 0; row < 3; row++) {
+      r[c][row] = a[0][row] * b[c][0] + a[1][row] * b[c][1] + a[2][row] * b[c][2];
+    }
+    r[c][3] = 0.0f;
+  }
+  for (int row = 0; row < 3; row++) {
+    r[3][row] += a[3][row];
+  }
+  r[3][3] = 1.0f;
+}
+
+static void chain_scalar(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind) {
+  for (int i = 0; i < f->joint_count; i++) {
+    int parent = f->joint_parents[i];
+    assert(parent < i);
+
+    mat4 local;
+    local_transform(local, f, rot, i);
+
+    if (parent >= 0) {
+      affine_mul(f->joint_transforms[i], f->joint_transforms[parent], local);
+    } else {
+      mat4_copy(f->joint_transforms[i], local);
+    }
+
+    if (inv_bind != NULL) {
+      affine_mul(f->transforms[i], f->joint_transforms[i], inv_bind[i]);
+    } else {
+      mat4_copy(f->transforms[i], f->joint_transforms[i]);
+    }
+  }
+}
+
+#ifdef POSE_KERNELS_X86
+
+// sse, 4 joints per register
+
+static inline __m128 slerp_correction_sse(__m128 d, __m128 shape) {
+  __m128 a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(1.43519f)))))));
+  __m128 b = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)))));
+  return _mm_add_ps(_mm_mul_ps(a, shape), b);
+}
+
+static void blend_sse(float* out, int out_stride, const float* a, const float* b, int in_stride, float amount, int lanes) {
+  __m128 vamount = _mm_set1_ps(amount);
+  __m128 keep = _mm_set1_ps(1.0f - amount);
+  __m128 shape = _mm_set1_ps((amount - 0.5f) * (amount - 0.5f));
+  __m128 bend = _mm_set1_ps(amount * (amount - 0.5f) * (amount - 1.0f));
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+
+  for (int c = POSE_X; c <= POSE_Z; c++) {
+    float* o = out + c * out_stride;
+    const float* ca = a + c * in_stride;
+    const float* cb = b + c * in_stride;
+    for (int i = 0; i < lanes; i += 4) {
+      __m128 va = _mm_loadu_ps(ca + i);
+      __m128 vb = _mm_loadu_ps(cb + i);
+      _mm_storeu_ps(o + i, _mm_add_ps(_mm_mul_ps(vb, vamount), _mm_mul_ps(va, keep)));
+    }
+  }
+
+  for (int i = 0; i < lanes; i += 4) {
+    __m128 ax = _mm_loadu_ps(a + POSE_QX * in_stride + i);
+    __m128 ay = _mm_loadu_ps(a + POSE_QY * in_stride + i);
+    __m128 az = _mm_loadu_ps(a + POSE_QZ * in_stride + i);
+    __m128 aw = _mm_loadu_ps(a + POSE_QW * in_stride + i);
+    __m128 bx = _mm_loadu_ps(b + POSE_QX * in_stride + i);
+    __m128 by = _mm_loadu_ps(b + POSE_QY * in_stride + i);
+    __m128 bz = _mm_loadu_ps(b + POSE_QZ * in_stride + i);
+    __m128 bw = _mm_loadu_ps(b + POSE_QW * in_stride + i);
+
+    __m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+    __m128 d = _mm_andnot_ps(sign, dot);
+
+    __m128 t = _mm_add_ps(vamount, _mm_mul_ps(bend, slerp_correction_sse(d, shape)));
+    __m128 t0 = _mm_sub_ps(one, t);
+    __m128 t1 = _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(dot, zero), sign));
+
+    __m128 x = _mm_add_ps(_mm_mul_ps(ax, t0), _mm_mul_ps(bx, t1));
+    __m128 y = _mm_add_ps(_mm_mul_ps(ay, t0), _mm_mul_ps(by, t1));
+    __m128 z = _mm_add_ps(_mm_mul_ps(az, t0), _mm_mul_ps(bz, t1));
+    __m128 w = _mm_add_ps(_mm_mul_ps(aw, t0), _mm_mul_ps(bw, t1));
+    __m128 length = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+    __m128 scale = _mm_div_ps(one, _mm_sqrt_ps(length));
+
+    _mm_storeu_ps(out + POSE_QX * out_stride + i, _mm_mul_ps(x, scale));
+    _mm_storeu_ps(out + POSE_QY * out_stride + i, _mm_mul_ps(y, scale));
+    _mm_storeu_ps(out + POSE_QZ * out_stride + i, _mm_mul_ps(z, scale));
+    _mm_storeu_ps(out + POSE_QW * out_stride + i, _mm_mul_ps(w, scale));
+  }
+}
+
+static void rotations_sse(float rot[9][MAX_JOINTS], const frame* f) {
+  int lanes = frame_lanes(f->joint_count);
+  __m128 two = _mm_set1_ps(2.0f);
+
+  for (int i = 0; i < lanes; i += 4) {
+    __m128 a = _mm_loadu_ps(&f->joints[POSE_QW][i]);
+    __m128 b = _mm_loadu_ps(&f->joints[POSE_QX][i]);
+    __m128 c = _mm_loadu_ps(&f->joints[POSE_QY][i]);
+    __m128 d = _mm_loadu_ps(&f->joints[POSE_QZ][i]);
+    __m128 a2 = _mm_mul_ps(a, a);
+    __m128 b2 = _mm_mul_ps(b, b);
+    __m128 c2 = _mm_mul_ps(c, c);
+    __m128 d2 = _mm_mul_ps(d, d);
+    __m128 ab = _mm_mul_ps(a, b);
+    __m128 ac = _mm_mul_ps(a, c);
+    __m128 ad = _mm_mul_ps(a, d);
+    __m128 bc = _mm_mul_ps(b, c);
+    __m128 bd = _mm_mul_ps(b, d);
+    __m128 cd = _mm_mul_ps(c, d);
+
+    _mm_storeu_ps(&rot[0][i], _mm_sub_ps(_mm_sub_ps(_mm_add_ps(a2, b2), c2), d2));
+    _mm_storeu_ps(&rot[1][i], _mm_mul_ps(two, _mm_add_ps(bc, ad)));
+    _mm_storeu_ps(&rot[2][i], _mm_mul_ps(two, _mm_sub_ps(bd, ac)));
+
+    _mm_storeu_ps(&rot[3][i], _mm_mul_ps(two, _mm_sub_ps(bc, ad)));
+    _mm_storeu_ps(&rot[4][i], _mm_sub_ps(_mm_add_ps(_mm_sub_ps(a2, b2), c2), d2));
+    _mm_storeu_ps(&rot[5][i], _mm_mul_ps(two, _mm_add_ps(cd, ab)));
+
+    _mm_storeu_ps(&rot[6][i], _mm_mul_ps(two, _mm_add_ps(bd, ac)));
+    _mm_storeu_ps(&rot[7][i], _mm_mul_ps(two, _mm_sub_ps(cd, ab)));
+    _mm_storeu_ps(&rot[8][i], _mm_add_ps(_mm_sub_ps(_mm_sub_ps(a2, b2), c2), d2));
+  }
+}
+
+/* columns of a * b for affine a (columns in registers) and b, like
+   affine_mul. the row of 0 0 0 1 is set rather than computed so the signed
+   zeros match too. the scalars come straight from memory: building b as a
+   matrix first would stall every load on the stores just made */
+static inline __m128 affine_sum(const __m128 a[4], float b0, float b1, float b2) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], _mm_set1_ps(b0)), _mm_mul_ps(a[1], _mm_set1_ps(b1))), _mm_mul_ps(a[2], _mm_set1_ps(b2)));
+}
+
+static inline __m128 affine_axis(const __m128 a[4], float b0, float b1, float b2, __m128 xyz) {
+  return _mm_and_ps(affine_sum(a, b0, b1, b2), xyz);
+}
+
+static inline __m128 affine_origin(const __m128 a[4], float b0, float b1, float b2, __m128 xyz, __m128 w) {
+  return _mm_or_ps(_mm_and_ps(_mm_add_ps(affine_sum(a, b0, b1, b2), a[3]), xyz), w);
+}
+
+/* the joints depend on their parents, so the chain is done one joint at a
+   time with a matrix column per register. the avx build of it is the same
+   code, where the scalars broadcast straight from memory */
+static inline __attribute__((always_inline)) void chain_columns(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind) {
+  __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  __m128 w = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+  for (int i = 0; i < f->joint_count; i++) {
+    int parent = f->joint_parents[i];
+    assert(parent < i);
+
+    float x = f->joints[POSE_X][i];
+    float y = f->joints[POSE_Y][i];
+    float z = f->joints[POSE_Z][i];
+
+    __m128 model[4];
+    if (parent >= 0) {
+      const vec4* m = f->joint_transforms[parent];
+      __m128 p[4] = { _mm_loadu_ps(m[0]), _mm_loadu_ps(m[1]), _mm_loadu_ps(m[2]), _mm_loadu_ps(m[3]) };
+      model[0] = affine_axis(p, rot[0][i], rot[1][i], rot[2][i], xyz);
+      model[1] = affine_axis(p, rot[3][i], rot[4][i], rot[5][i], xyz);
+      model[2] = affine_axis(p, rot[6][i], rot[7][i], rot[8][i], xyz);
+      model[3] = affine_origin(p, x, y, z, xyz, w);
+    } else {
+      model[0] = _mm_setr_ps(rot[0][i], rot[1][i], rot[2][i], 0.0f);
+      model[1] = _mm_setr_ps(rot[3][i], rot[4][i], rot[5][i], 0.0f);
+      model[2] = _mm_setr_ps(rot[6][i], rot[7][i], rot[8][i], 0.0f);
+      model[3] = _mm_setr_ps(x, y, z, 1.0f);
+    }
+
+    __m128 palette[4] = { model[0], model[1], model[2], model[3] };
+    if (inv_bind != NULL) {
+      const vec4* b = inv_bind[i];
+      palette[0] = affine_axis(model, b[0][0], b[0][1], b[0][2], xyz);
+      palette[1] = affine_axis(model, b[1][0], b[1][1], b[1][2], xyz);
+      palette[2] = affine_axis(model, b[2][0], b[2][1], b[2][2], xyz);
+      palette[3] = affine_origin(model, b[3][0], b[3][1], b[3][2], xyz, w);
+    }
+
+    for (int c = 0; c < 4; c++) {
+      _mm_storeu_ps(f->joint_transforms[i][c], model[c]);
+      _mm_storeu_ps(f->transforms[i][c], palette[c]);
+    }
+  }
+}
+
+static void chain_sse(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind) {
+  chain_columns(f, rot, inv_bind);
+}
+
+// avx, 8 joints per register
+
+__attribute__((target("avx")))
+static inline __m256 slerp_correction_avx(__m256 d, __m256 shape) {
+  __m256 a = _mm256_add_ps(_mm256_set1_ps(1.0904f), _mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(-3.2452f), _mm256_mul_ps(d, _mm256_sub_ps(_mm256_set1_ps(3.55645f), _mm256_mul_ps(d, _mm256_set1_ps(1.43519f)))))));
+  __m256 b = _mm256_add_ps(_mm256_set1_ps(0.848013f), _mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(-1.06021f), _mm256_mul_ps(d, _mm256_set1_ps(0.215638f)))));
+  return _mm256_add_ps(_mm256_mul_ps(a, shape), b);
+}
+
+__attribute__((target("avx")))
+static void blend_avx(float* out, int out_stride, const float* a, const float* b, int in_stride, float amount, int lanes) {
+  __m256 vamount = _mm256_set1_ps(amount);
+  __m256 keep = _mm256_set1_ps(1.0f - amount);
+  __m256 shape = _mm256_set1_ps((amount - 0.5f) * (amount - 0.5f));
+  __m256 bend = _mm256_set1_ps(amount * (amount - 0.5f) * (amount - 1.0f));
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 one = _mm256_set1_ps(1.0f);
+
+  for (int c = POSE_X; c <= POSE_Z; c++) {
+    float* o = out + c * out_stride;
+    const float* ca = a + c * in_stride;
+    const float* cb = b + c * in_stride;
+    for (int i = 0; i < lanes; i += 8) {
+      __m256 va = _mm256_loadu_ps(ca + i);
+      __m256 vb = _mm256_loadu_ps(cb + i);
+      _mm256_storeu_ps(o + i, _mm256_add_ps(_mm256_mul_ps(vb, vamount), _mm256_mul_ps(va, keep)));
+    }
+  }
+
+  for (int i = 0; i < lanes; i += 8) {
+    __m256 ax = _mm256_loadu_ps(a + POSE_QX * in_stride + i);
+    __m256 ay = _mm256_loadu_ps(a + POSE_QY * in_stride + i);
+    __m256 az = _mm256_loadu_ps(a + POSE_QZ * in_stride + i);
+    __m256 aw = _mm256_loadu_ps(a + POSE_QW * in_stride + i);
+    __m256 bx = _mm256_loadu_ps(b + POSE_QX * in_stride + i);
+    __m256 by = _mm256_loadu_ps(b + POSE_QY * in_stride + i);
+    __m256 bz = _mm256_loadu_ps(b + POSE_QZ * in_stride + i);
+    __m256 bw = _mm256_loadu_ps(b + POSE_QW * in_stride + i);
+
+    __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz)), _mm256_mul_ps(aw, bw));
+    __m256 d = _mm256_andnot_ps(sign, dot);
+
+    __m256 t = _mm256_add_ps(vamount, _mm256_mul_ps(bend, slerp_correction_avx(d, shape)));
+    __m256 t0 = _mm256_sub_ps(one, t);
+    __m256 t1 = _mm256_xor_ps(t, _mm256_and_ps(_mm256_cmp_ps(dot, zero, _CMP_LT_OQ), sign));
+
+    __m256 x = _mm256_add_ps(_mm256_mul_ps(ax, t0), _mm256_mul_ps(bx, t1));
+    __m256 y = _mm256_add_ps(_mm256_mul_ps(ay, t0), _mm256_mul_ps(by, t1));
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(az, t0), _mm256_mul_ps(bz, t1));
+    __m256 w = _mm256_add_ps(_mm256_mul_ps(aw, t0), _mm256_mul_ps(bw, t1));
+    __m256 length = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)), _mm256_mul_ps(w, w));
+    __m256 scale = _mm256_div_ps(one, _mm256_sqrt_ps(length));
+
+    _mm256_storeu_ps(out + POSE_QX * out_stride + i, _mm256_mul_ps(x, scale));
+    _mm256_storeu_ps(out + POSE_QY * out_stride + i, _mm256_mul_ps(y, scale));
+    _mm256_storeu_ps(out + POSE_QZ * out_stride + i, _mm256_mul_ps(z, scale));
+    _mm256_storeu_ps(out + POSE_QW * out_stride + i, _mm256_mul_ps(w, scale));
+  }
+}
+
+__attribute__((target("avx")))
+static void rotations_avx(float rot[9][MAX_JOINTS], const frame* f) {
+  int lanes = frame_lanes(f->joint_count);
+  __m256 two = _mm256_set1_ps(2.0f);
+
+  for (int i = 0; i < lanes; i += 8) {
+    __m256 a = _mm256_loadu_ps(&f->joints[POSE_QW][i]);
+    __m256 b = _mm256_loadu_ps(&f->joints[POSE_QX][i]);
+    __m256 c = _mm256_loadu_ps(&f->joints[POSE_QY][i]);
+    __m256 d = _mm256_loadu_ps(&f->joints[POSE_QZ][i]);
+    __m256 a2 = _mm256_mul_ps(a, a);
+    __m256 b2 = _mm256_mul_ps(b, b);
+    __m256 c2 = _mm256_mul_ps(c, c);
+    __m256 d2 = _mm256_mul_ps(d, d);
+    __m256 ab = _mm256_mul_ps(a, b);
+    __m256 ac = _mm256_mul_ps(a, c);
+    __m256 ad = _mm256_mul_ps(a, d);
+    __m256 bc = _mm256_mul_ps(b, c);
+    __m256 bd = _mm256_mul_ps(b, d);
+    __m256 cd = _mm256_mul_ps(c, d);
+
+    _mm256_storeu_ps(&rot[0][i], _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(a2, b2), c2), d2));
+    _mm256_storeu_ps(&rot[1][i], _mm256_mul_ps(two, _mm256_add_ps(bc, ad)));
+    _mm256_storeu_ps(&rot[2][i], _mm256_mul_ps(two, _mm256_sub_ps(bd, ac)));
+
+    _mm256_storeu_ps(&rot[3][i], _mm256_mul_ps(two, _mm256_sub_ps(bc, ad)));
+    _mm256_storeu_ps(&rot[4][i], _mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(a2, b2), c2), d2));
+    _mm256_storeu_ps(&rot[5][i], _mm256_mul_ps(two, _mm256_add_ps(cd, ab)));
+
+    _mm256_storeu_ps(&rot[6][i], _mm256_mul_ps(two, _mm256_add_ps(bd, ac)));
+    _mm256_storeu_ps(&rot[7][i], _mm256_mul_ps(two, _mm256_sub_ps(cd, ab)));
+    _mm256_storeu_ps(&rot[8][i], _mm256_add_ps(_mm256_sub_ps(_mm256_sub_ps(a2, b2), c2), d2));
+  }
+}
+
+__attribute__((target("avx")))
+static void chain_avx(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind) {
+  chain_columns(f, rot, inv_bind);
+}
+
+#endif
+
+// dispatch
+
+static void (*blend_kernel)(float* out, int out_stride, const float* a, const float* b, int in_stride, float amount, int lanes) = blend_scalar;
+static void (*rotations_kernel)(float rot[9][MAX_JOINTS], const frame* f) = rotations_scalar;
+static void (*chain_kernel)(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind) = chain_scalar;
+
+static pose_kernels_level supported_level() {
+#ifdef POSE_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx")) return POSE_KERNELS_AVX;
+  if (__builtin_cpu_supports("sse2")) return POSE_KERNELS_SSE;
+#endif
+  return POSE_KERNELS_SCALAR;
+}
+
+void pose_kernels_init() {
+  pose_kernels_level level = pose_kernels_select(POSE_KERNELS_AVX);
+  printf("[pose] using %s kernels\n", pose_kernels_name(level));
+}
+
+pose_kernels_level pose_kernels_select(pose_kernels_level level) {
+  pose_kernels_level supported = supported_level();
+  if (level > supported) {
+    level = supported;
+  }
+
+  blend_kernel = blend_scalar;
+  rotations_kernel = rotations_scalar;
+  chain_kernel = chain_scalar;
+#ifdef POSE_KERNELS_X86
+  if (level == POSE_KERNELS_SSE) {
+    blend_kernel = blend_sse;
+    rotations_kernel = rotations_sse;
+    chain_kernel = chain_sse;
+  } else if (level == POSE_KERNELS_AVX) {
+    blend_kernel = blend_avx;
+    rotations_kernel = rotations_avx;
+    chain_kernel = chain_avx;
+  }
+#endif
+
+  return level;
+}
+
+const char* pose_kernels_name(pose_kernels_level level) {
+  switch (level) {
+    case POSE_KERNELS_SSE: return "sse";
+    case POSE_KERNELS_AVX: return "avx";
+    default: return "scalar";
+  }
+}
+
+void pose_blend(float* out, int out_stride, const float* a, const float* b, int in_stride, float amount, int lanes) {
+  blend_kernel(out, out_stride, a, b, in_stride, amount, lanes);
+}
+
+void pose_rotations(float rot[9][MAX_JOINTS], const frame* f) {
+  rotations_kernel(rot, f);
+}
+
+void pose_chain(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind) {
+  chain_kernel(f, rot, inv_bind);
+}
@@ -0,0 +1,37 @@
+#ifndef pose_kernels_h
+#define pose_kernels_h
+
+#include "engine.h"
+#include "data/frame.h"
+
+typedef enum {
+  POSE_KERNELS_SCALAR,
+  POSE_KERNELS_SSE,  // 4 joints at once, sse2
+  POSE_KERNELS_AVX   // 8 joints at once
+} pose_kernels_level;
+
+/* picks the widest kernels the cpu runs. until it is called every pose is
+   done by the scalar ones, which give the same bits (the simd ones do the
+   same operations in the same order, without fused multiply-adds) */
+void pose_kernels_init();
+
+// uses the given kernels, or the widest supported below them, and returns
+// the ones picked
+pose_kernels_level pose_kernels_select(pose_kernels_level level);
+const char* pose_kernels_name(pose_kernels_level level);
+
+/* out = a blended towards b by amount, over channel blocks of joints (see
+   frame.h, the strides are the distance between two channels): translations
+   are lerped, rotations nlerped along the shorter arc. lanes is a multiple
+   of POSE_LANES, out may be a */
+void pose_blend(float* out, int out_stride, const float* a, const float* b, int in_stride, float amount, int lanes);
+
+// the 3x3 rotation of every joint from its quaternion, column major:
+// rot[col * 3 + row][joint]
+void pose_rotations(float rot[9][MAX_JOINTS], const frame* f);
+
+// model space transforms of f from its rotations, parent by parent, then
+// times inv_bind (NULL for none)
+void pose_chain(frame* f, const float rot[9][MAX_JOINTS], const mat4* inv_bind);
+
+#endif
@@ -1,4 +1,3 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include "renderer.h"
 
 #define SHADOW_WIDTH 1024
@@ -8,6 +7,7 @@
 #define SSAO_MAX_NOISE_SIZE 16
 
 #define MAX_OMNI_SHADOWS 4
+#define OMNI_SHADOWS_FAR_PLANE 25.0f
 
 GLuint renderer_geometry_shader;
 GLuint renderer_lighting_shader;
@@ -58,6 +58,36 @@ float renderer_shadow_near;
 float renderer_shadow_far;
 float renderer_shadow_size;
 
+// texture binds of the last frame
+int renderer_texture_binds;
+
+// detail levels: error in pixels a level may show, and the triangles drawn
+// with each level in the last frame
+float renderer_lod_pixels;
+float renderer_shadow_lod_pixels;
+int renderer_lod_triangles[MESH_MAX_LODS];
+int renderer_shadow_lod_triangles[MESH_MAX_LODS];
+
+// where a pass looks from, for picking detail levels
+typedef struct {
+  vec3 eye;
+  int orthographic;   // the same level at any distance
+  float pixels;       // pixels per world unit, at distance 1 unless orthographic
+  float tolerance;
+  int* triangles;
+} lod_view;
+
+// objects with the arrays of their first material, for sorting
+typedef struct {
+  object* o;
+  GLuint arrays[3];
+} material_order;
+
+// sort buffers, grown to the most objects a frame has drawn
+static material_order* sort_order;
+static object** sort_objects;
+static int sort_capacity;
+
 // omni-directional shadows
 GLuint renderer_depth_cubemaps[MAX_OMNI_SHADOWS];
 GLuint renderer_depth_cubemap_fbos[MAX_OMNI_SHADOWS];
@@ -69,52 +99,9 @@ void set_opengl_state() {
   // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 }
 
+// shared through the texture cache, decoded on the texture loader's workers
 unsigned int load_image(char* filename) {
-  GLuint texture = -1;
-
-  if (strlen(filename) == 0) {
-    return 0;
-  }
-
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  // set the texture wrapping parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);	// set texture wrapping to GL_REPEAT (default wrapping method)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  // set texture filtering parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  // load image, create texture and generate mipmaps
-  int width, height, nrChannels;
-  stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-  // The FileSystem::getPath(...) is part of the GitHub repository so we can find files on any IDE/platform; replace it with your own image path.
-  unsigned char *data = stbi_load(filename, &width, &height, &nrChannels, 0);
-  if (data) {
-    GLenum format;
-    if (nrChannels == 1)
-      format = GL_RED;
-    if (nrChannels == 2)
-      format = GL_ALPHA;
-    else if (nrChannels == 3)
-      format = GL_RGB;
-    else if (nrChannels == 4)
-      format = GL_RGBA;
-
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  }
-  else {
-    printf("Error loading texture: %s\n", filename);
-  }
-
-  stbi_image_free(data);
-  return texture;
+  return texture_cache_load(filename);
 }
 
 static void init_depth_fbo() {
@@ -288,6 +275,10 @@ int renderer_init(int width, int height) {
   // init gbuffer
   init_g_buffer(width, height);
 
+  // static objects have no skin stream, their joint attributes read these
+  glVertexAttribI4ui(4, 0, 0, 0, 0);
+  glVertexAttrib4f(5, 0.0f, 0.0f, 0.0f, 0.0f);
+
   // init vars
   renderer_render_aabb = 0;
   renderer_shadow_near = 1.0f;
@@ -297,6 +288,8 @@ int renderer_init(int width, int height) {
   renderer_shadows_debug_enabled = 0;
   renderer_shadow_bias = 0.22f;
   renderer_shadow_pcf_enabled = 1;
+  renderer_lod_pixels = 1.0f;
+  renderer_shadow_lod_pixels = 4.0f;
 
   // omni-directional shadow mapping
   init_omni_shadows();
@@ -321,7 +314,13 @@ int renderer_init(int width, int height) {
   return 0;
 }
 
-void renderer_free() {}
+void renderer_free() {
+  free(sort_order);
+  free(sort_objects);
+  sort_order = NULL;
+  sort_objects = NULL;
+  sort_capacity = 0;
+}
 
 void renderer_recompile_shader() {
   shader_compile("../engine/shaders/geometry.vs", "../engine/shaders/geometry.fs", NULL, &renderer_geometry_shader);
@@ -379,49 +378,121 @@ static void add_aabb(object* o) {
 }
 
 void renderer_init_object(object* o) {
+  GLuint vao, vbo, skin_vbo = 0, ebo;
+  glGenVertexArrays(1, &vao); // Vertex Array Object
+  glGenBuffers(1, &vbo);      // Vertex Buffer Object
+  glGenBuffers(1, &ebo);      // Element Buffer Object
+
+  // one vertex and index buffer for the whole object, each mesh draws its range.
+  // indices count from the first vertex of their mesh, so they are 16 bit
+  // unless a mesh has more vertices than that
+  int total_vertices = 0, total_indices = 0;
+  GLenum index_type = GL_UNSIGNED_SHORT;
+  for (int i = 0; i < o->num_meshes; i++) {
+    total_vertices += o->meshes[i].num_vertices;
+    total_indices += mesh_total_indices(&o->meshes[i]);
+    if (o->meshes[i].num_vertices > 65536) index_type = GL_UNSIGNED_INT;
+  }
+
+  // baked objects bring their streams and bounds, the others are packed
+  // here (the meshes keep the full vertices for the cpu side)
+  const vertex_packed* packed = o->streams.packed;
+  const vertex_skin* skin = o->streams.skin;
+  const void* indices = o->streams.indices;
+  vertex_packed* packed_copy = NULL;
+  vertex_skin* skin_copy = NULL;
+  char* indices_copy = NULL;
+  if (packed != NULL) {
+    index_type = o->streams.index_type;
+  } else {
+    packed = packed_copy = malloc((total_vertices > 0 ? total_vertices : 1) * sizeof(vertex_packed));
+    skin = skin_copy = o->skel != NULL ? malloc((total_vertices > 0 ? total_vertices : 1) * sizeof(vertex_skin)) : NULL;
+  }
+  size_t index_size = index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+  if (indices == NULL) {
+    indices = indices_copy = malloc((total_indices > 0 ? total_indices : 1) * index_size);
+  }
+
+  GLuint first_vertex = 0, first_index = 0;
   for (int i = 0; i < o->num_meshes; i++) {
     mesh* mesh = &o->meshes[i];
-    glGenVertexArrays(1, &(mesh->vao)); // Vertex Array Object
-    glGenBuffers(1, &(mesh->vbo));      // Vertex Buffer Object
-    glGenBuffers(1, &(mesh->ebo));      // Element Buffer Object
+    mesh->vao = vao;
+    mesh->vbo = vbo;
+    mesh->ebo = ebo;
+    mesh->index_type = index_type;
+    mesh->base_vertex = first_vertex;
+    mesh->first_index = first_index;
+
+    GLuint mesh_indices = mesh_total_indices(mesh);
+    if (packed_copy != NULL) {
+      for (GLuint j = 0; j < mesh->num_vertices; j++) {
+        vertex_pack(&mesh->vertices[j], &packed_copy[first_vertex + j]);
+        if (skin_copy != NULL) vertex_pack_skin(&mesh->vertices[j], &skin_copy[first_vertex + j]);
+      }
+      // all detail levels, they follow each other in the mesh's indices
+      for (GLuint j = 0; j < mesh_indices; j++) {
+        if (index_type == GL_UNSIGNED_SHORT) ((GLushort*)indices_copy)[first_index + j] = mesh->indices[j];
+        else ((GLuint*)indices_copy)[first_index + j] = mesh->indices[j];
+      }
+      mesh_compute_bounds(mesh);
+    }
+    first_vertex += mesh->num_vertices;
+    first_index += mesh_indices;
+  }
 
-    glBindVertexArray(mesh->vao);
+  glBindVertexArray(vao);
 
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-    glBufferData(GL_ARRAY_BUFFER, mesh->num_vertices * sizeof(vertex), mesh->vertices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, total_indices * index_size, indices, GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->num_indices * sizeof(GLuint), mesh->indices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, total_vertices * sizeof(vertex_packed), packed, GL_STATIC_DRAW);
 
-    // sum of all vertex components
-    int total_size = 17;
+  GLsizei stride = sizeof(vertex_packed);
 
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, total_size * sizeof(GLfloat), (GLvoid *)0);
-    glEnableVertexAttribArray(0);
+  // position attribute
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid *)offsetof(vertex_packed, x));
+  glEnableVertexAttribArray(0);
 
-    // texture coord attribute
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, total_size * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
+  // texture coord attribute
+  glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (GLvoid *)offsetof(vertex_packed, u));
+  glEnableVertexAttribArray(1);
 
-    // normals attribute
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, total_size * sizeof(GLfloat), (GLvoid *)(5 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
+  // normals attribute
+  glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (GLvoid *)offsetof(vertex_packed, normal));
+  glEnableVertexAttribArray(2);
+
+  // tangents attribute
+  glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (GLvoid *)offsetof(vertex_packed, tangent));
+  glEnableVertexAttribArray(3);
 
-    // tangents attribute
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, total_size * sizeof(GLfloat), (GLvoid *)(8 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(3);
+  if (skin != NULL) {
+    glGenBuffers(1, &skin_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, skin_vbo);
+    glBufferData(GL_ARRAY_BUFFER, total_vertices * sizeof(vertex_skin), skin, GL_STATIC_DRAW);
 
     // joint ids attribute
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, total_size * sizeof(GLfloat), (GLvoid *)(11 * sizeof(GLfloat)));
+    glVertexAttribIPointer(4, 4, GL_UNSIGNED_BYTE, sizeof(vertex_skin), (GLvoid *)offsetof(vertex_skin, joints));
     glEnableVertexAttribArray(4);
 
     // weights attribute
-    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, total_size * sizeof(GLfloat), (GLvoid *)(14 * sizeof(GLfloat)));
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex_skin), (GLvoid *)offsetof(vertex_skin, weights));
     glEnableVertexAttribArray(5);
+  }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+  for (int i = 0; i < o->num_meshes; i++) {
+    o->meshes[i].skin_vbo = skin_vbo;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  free(packed_copy);
+  free(skin_copy);
+  free(indices_copy);
+
+  for (int i = 0; i < o->num_meshes; i++) {
+    mesh* mesh = &o->meshes[i];
 
     // texture
     mesh->texture_id = load_image(mesh->mat.texture_path);
@@ -435,10 +506,19 @@ void renderer_init_object(object* o) {
 }
 
 void renderer_free_object(object* o) {
+  // the meshes share the object's buffers
+  if (o->num_meshes > 0) {
+    glDeleteVertexArrays(1, &(o->meshes[0].vao));
+    glDeleteBuffers(1, &(o->meshes[0].vbo));
+    glDeleteBuffers(1, &(o->meshes[0].ebo));
+    if (o->meshes[0].skin_vbo != 0) glDeleteBuffers(1, &(o->meshes[0].skin_vbo));
+  }
+
   for (int i = 0; i < o->num_meshes; i++) {
-    glDeleteVertexArrays(1, &(o->meshes[i].vao));
-    glDeleteBuffers(1, &(o->meshes[i].vbo));
-    glDeleteBuffers(1, &(o->meshes[i].ebo));
+    texture_cache_release(o->meshes[i].texture_id);
+    texture_cache_release(o->meshes[i].normal_map_id);
+    texture_cache_release(o->meshes[i].specular_map_id);
+    texture_cache_release(o->meshes[i].mask_map_id);
   }
 }
 
@@ -483,6 +563,7 @@ void renderer_free_particle_generator(particle_generator* pg) {
   glDeleteVertexArrays(1, &(pg->vao));
   glDeleteBuffers(1, &(pg->vbo_quad));
   glDeleteBuffers(1, &(pg->vbo_pos));
+  texture_cache_release(pg->sprite_id);
 }
 
 static void render_aabb(object* o) {
@@ -519,12 +600,75 @@ static void render_aabb(object* o) {
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-static void render_object(object* o, GLuint shader_id) {
+// array bound to each material texture unit this frame, binding it again is skipped
+static GLuint bound_arrays[5];
+
+static void bind_array(int unit, GLuint texture) {
+  if (bound_arrays[unit] == texture) {
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  bound_arrays[unit] = texture;
+  renderer_texture_binds++;
+}
+
+// binds the array holding the map, returns its layer or -1 if the material has none
+static int bind_map(int unit, const char* path, GLuint texture) {
+  if (strlen(path) == 0) {
+    return -1;
+  }
+  int layer;
+  bind_array(unit, texture_streamer_array(texture, &layer));
+  return layer;
+}
+
+/* coarsest level whose error, projected from the nearest point of the
+   meshes' bounding spheres, stays within the pass tolerance. one level for
+   the whole object, meshes with fewer levels use their coarsest */
+static int select_lod(object* o, const lod_view* view) {
+  float scale = vec3_len(o->world_transform[0]);
+  float distance = FLT_MAX;
+  int levels = 1;
+  for (int i = 0; i < o->num_meshes; i++) {
+    mesh* mesh = &o->meshes[i];
+    if (mesh->num_lods > levels) levels = mesh->num_lods;
+    if (view->orthographic) continue;
+
+    vec4 center = { mesh->center[0], mesh->center[1], mesh->center[2], 1.0f };
+    vec4 world_center;
+    mat4_mul_vec4(world_center, o->world_transform, center);
+
+    vec3 to_center;
+    vec3_sub(to_center, world_center, view->eye);
+    float d = vec3_len(to_center) - mesh->radius * scale;
+    if (d < distance) distance = d;
+  }
+  if (view->orthographic) distance = 1.0f;
+  if (distance < 0.1f) distance = 0.1f;
+
+  int lod = 0;
+  for (int l = 1; l < levels; l++) {
+    for (int i = 0; i < o->num_meshes; i++) {
+      mesh* mesh = &o->meshes[i];
+      float error = mesh->lod_error[l < mesh->num_lods ? l : mesh->num_lods - 1] * scale;
+      if (error * view->pixels / distance > view->tolerance) return lod;
+    }
+    lod = l;
+  }
+  return lod;
+}
+
+static void render_object(object* o, GLuint shader_id, const lod_view* view) {
+  if (o->num_meshes <= 0) {
+    return;
+  }
+
   glUniformMatrix4fv(glGetUniformLocation(shader_id, "M"), 1, GL_FALSE, (const GLfloat*) o->world_transform);
 
   // handle animated objects
   if (o->skel != NULL) {
-    glUniformMatrix4fv(glGetUniformLocation(shader_id, "bone_transforms"), o->skel->joint_count, GL_FALSE, (const GLfloat*) o->skel->current_frame.transforms);
+    glUniformMatrix4fv(glGetUniformLocation(shader_id, "bone_transforms"), o->skel->joint_count, GL_FALSE, (const GLfloat*) o->pose->transforms);
     glUniform1i(glGetUniformLocation(shader_id, "has_skeleton"), 1);
   } else {
     glUniform1i(glGetUniformLocation(shader_id, "has_skeleton"), 0);
@@ -536,6 +680,9 @@ static void render_object(object* o, GLuint shader_id) {
   glUniform3fv(glGetUniformLocation(shader_id, "glow_color"), 1, o->glow_color);
   glUniform1i(glGetUniformLocation(shader_id, "receive_shadows"), o->receive_shadows);
 
+  glBindVertexArray(o->meshes[0].vao);
+  int lod = select_lod(o, view);
+
   for (int i = 0; i < o->num_meshes; i++) {
     mesh* mesh = &o->meshes[i];
 
@@ -546,59 +693,131 @@ static void render_object(object* o, GLuint shader_id) {
 
     glUniform1i(glGetUniformLocation(shader_id, "texture_subdivision"), mesh->mat.texture_subdivision);
 
-    // bind texture
-    if (strlen(mesh->mat.texture_path) > 0) {
-      glUniform1i(glGetUniformLocation(shader_id, "texture_diffuse"), 1);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, mesh->texture_id);
-      glUniform1i(glGetUniformLocation(shader_id, "has_diffuse_map"), 1);
-    } else {
-      glUniform1i(glGetUniformLocation(shader_id, "has_diffuse_map"), 0);
-    }
+    // maps live in array layers, meshes whose maps share arrays draw without rebinding
+    glUniform1i(glGetUniformLocation(shader_id, "texture_diffuse"), 1);
+    glUniform1i(glGetUniformLocation(shader_id, "diffuse_layer"), bind_map(1, mesh->mat.texture_path, mesh->texture_id));
 
-    // bind normal map
-    if (strlen(mesh->mat.normal_map_path) > 0) {
-      glUniform1i(glGetUniformLocation(shader_id, "texture_normal"), 2);
-      glActiveTexture(GL_TEXTURE2);
-      glBindTexture(GL_TEXTURE_2D, mesh->normal_map_id);
-      glUniform1i(glGetUniformLocation(shader_id, "has_normal_map"), 1);
-    } else {
-      glUniform1i(glGetUniformLocation(shader_id, "has_normal_map"), 0);
-    }
+    glUniform1i(glGetUniformLocation(shader_id, "texture_normal"), 2);
+    glUniform1i(glGetUniformLocation(shader_id, "normal_layer"), bind_map(2, mesh->mat.normal_map_path, mesh->normal_map_id));
 
-    // bind specular map
-    if (strlen(mesh->mat.specular_map_path) > 0) {
-      glUniform1i(glGetUniformLocation(shader_id, "texture_specular"), 3);
-      glActiveTexture(GL_TEXTURE3);
-      glBindTexture(GL_TEXTURE_2D, mesh->specular_map_id);
-      glUniform1i(glGetUniformLocation(shader_id, "has_specular_map"), 1);
-    } else {
-      glUniform1i(glGetUniformLocation(shader_id, "has_specular_map"), 0);
-    }
+    glUniform1i(glGetUniformLocation(shader_id, "texture_specular"), 3);
+    glUniform1i(glGetUniformLocation(shader_id, "specular_layer"), bind_map(3, mesh->mat.specular_map_path, mesh->specular_map_id));
 
-    // bind mask map
-    if (strlen(mesh->mat.mask_map_path) > 0) {
-      glUniform1i(glGetUniformLocation(shader_id, "texture_mask"), 4);
-      glActiveTexture(GL_TEXTURE4);
-      glBindTexture(GL_TEXTURE_2D, mesh->mask_map_id);
-      glUniform1i(glGetUniformLocation(shader_id, "has_mask_map"), 1);
-    } else {
-      glUniform1i(glGetUniformLocation(shader_id, "has_mask_map"), 0);
+    glUniform1i(glGetUniformLocation(shader_id, "texture_mask"), 4);
+    glUniform1i(glGetUniformLocation(shader_id, "mask_layer"), bind_map(4, mesh->mat.mask_map_path, mesh->mask_map_id));
+
+    // render the level's range of the object buffers
+    int level = lod < mesh->num_lods ? lod : mesh->num_lods - 1;
+    GLuint first = mesh->first_index;
+    for (int l = 0; l < level; l++) {
+      first += mesh->lod_indices[l];
     }
+    view->triangles[level] += mesh->lod_indices[level] / 3;
 
-    // render the mesh
-    glBindVertexArray(mesh->vao);
-    glDrawElements(GL_TRIANGLES, mesh->num_indices, GL_UNSIGNED_INT , 0);
+    size_t index_size = mesh->index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh->lod_indices[level], mesh->index_type,
+      (GLvoid *)(first * index_size), mesh->base_vertex);
   }
 
   if (renderer_render_aabb)
     render_aabb(o);
 }
 
-static void render_objects(object *objects[], int objects_length, GLuint shader_id) {
+static int compare_material_order(const void* a, const void* b) {
+  const material_order* x = a;
+  const material_order* y = b;
+  for (int i = 0; i < 3; i++) {
+    if (x->arrays[i] != y->arrays[i]) {
+      return x->arrays[i] < y->arrays[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+static GLuint map_array(const char* path, GLuint texture) {
+  int layer;
+  return strlen(path) > 0 ? texture_streamer_array(texture, &layer) : 0;
+}
+
+static void reserve_sort_buffers(int count) {
+  if (count <= sort_capacity) {
+    return;
+  }
+
+  sort_order = realloc(sort_order, count * sizeof(material_order));
+  sort_objects = realloc(sort_objects, count * sizeof(object*));
+  if (sort_order == NULL || sort_objects == NULL) {
+    printf("[renderer] unable to allocate sort buffers for %d objects\n", count);
+    exit(1);
+  }
+  sort_capacity = count;
+}
+
+// draw order with the objects sharing texture arrays next to each other,
+// written to sort_objects
+static void sort_by_material(object* objects[], int objects_length) {
+  reserve_sort_buffers(objects_length);
+  material_order* order = sort_order;
+  for (int i = 0; i < objects_length; i++) {
+    object* o = objects[i];
+    order[i].o = o;
+    order[i].arrays[0] = order[i].arrays[1] = order[i].arrays[2] = 0;
+    if (o->num_meshes > 0) {
+      mesh* mesh = &o->meshes[0];
+      order[i].arrays[0] = map_array(mesh->mat.texture_path, mesh->texture_id);
+      order[i].arrays[1] = map_array(mesh->mat.normal_map_path, mesh->normal_map_id);
+      order[i].arrays[2] = map_array(mesh->mat.specular_map_path, mesh->specular_map_id);
+    }
+  }
+
+  if (objects_length > 1) {
+    qsort(order, objects_length, sizeof(material_order), compare_material_order);
+  }
+  for (int i = 0; i < objects_length; i++) {
+    sort_objects[i] = order[i].o;
+  }
+}
+
+static void render_objects(object *objects[], int objects_length, GLuint shader_id, const lod_view* view) {
+  for (int i = 0; i < objects_length; i++) {
+    object* o = objects[i];
+    render_object(o, shader_id, view);
+  }
+}
+
+// screen space feedback for the texture streamer: how much of each texture one
+// pixel covers at the nearest point of the mesh's bounding sphere
+static void request_texture_levels(object* objects[], int objects_length, vec3 eye, vec3 front, int height) {
+  // world size of a pixel at distance 1
+  float pixel_size = 2.0f * tanf(to_radians(45.0f) / 2.0f) / height;
+
   for (int i = 0; i < objects_length; i++) {
     object* o = objects[i];
-    render_object(o, shader_id);
+    float scale = vec3_len(o->world_transform[0]);
+    if (scale <= 0.0f) continue;
+
+    for (int j = 0; j < o->num_meshes; j++) {
+      mesh* mesh = &o->meshes[j];
+      vec4 center = { mesh->center[0], mesh->center[1], mesh->center[2], 1.0f };
+      vec4 world_center;
+      mat4_mul_vec4(world_center, o->world_transform, center);
+
+      vec3 to_center;
+      vec3_sub(to_center, world_center, eye);
+      float radius = mesh->radius * scale;
+
+      // behind the camera
+      if (vec3_dot(to_center, front) < -radius) continue;
+
+      float distance = vec3_len(to_center) - radius;
+      if (distance < 0.1f) distance = 0.1f;
+
+      float uv_per_pixel = distance * pixel_size * mesh->uv_density * mesh->mat.texture_subdivision / scale;
+      texture_streamer_request(mesh->texture_id, uv_per_pixel);
+      texture_streamer_request(mesh->normal_map_id, uv_per_pixel);
+      texture_streamer_request(mesh->specular_map_id, uv_per_pixel);
+      texture_streamer_request(mesh->mask_map_id, uv_per_pixel);
+    }
   }
 }
 
@@ -641,7 +860,7 @@ static void calculate_world_transform(object* o) {
     mat4_mul(parent_transform, parent_transform, o->parent->world_transform);
 
     if (o->parent_joint >= 0) {
-      mat4_mul(parent_transform, parent_transform, o->parent->skel->current_frame.transforms[o->parent_joint]);
+      mat4_mul(parent_transform, parent_transform, o->parent->pose->transforms[o->parent_joint]);
     }
   }
 
@@ -679,6 +898,30 @@ static void calculate_world_transform(object* o) {
   o->calculate_transform = 0;
 }
 
+// view and projection of the camera pass
+static void camera_matrices(int width, int height, camera* camera, mat4 v, mat4 p) {
+  vec3 camera_dir;
+  vec3_add(camera_dir, camera->pos, camera->front);
+  mat4_look_at(v, camera->pos, camera_dir, camera->up);
+  mat4_perspective(p, to_radians(45.0f), width / (float)height, 0.1f, 100.0f);
+}
+
+// a directional light's shadow box, moved with the camera
+static void directional_light_space(camera* camera, light* l, mat4 light_space) {
+  mat4 light_proj, light_view;
+  mat4_ortho(light_proj, -renderer_shadow_size, renderer_shadow_size, -renderer_shadow_size, renderer_shadow_size, renderer_shadow_near, renderer_shadow_far);
+  vec3 up = { 0.0f, 0.0f, 1.0f };
+
+  // move directional light with camera
+  vec3 light_cam_pos;
+  light_cam_pos[0] = camera->pos[0] + l->position[0];
+  light_cam_pos[1] = l->position[1];
+  light_cam_pos[2] = camera->pos[2] + l->position[2];
+
+  mat4_look_at(light_view, light_cam_pos, l->dir, up);
+  mat4_mul(light_space, light_proj, light_view);
+}
+
 static void pass_light_uniform(int light_index, light* l, mat4 view, mat4 light_space_matrix, GLuint shader_id) {
   char uniform_light_type[256];
   sprintf(uniform_light_type, "lights[%d].type", light_index);
@@ -821,10 +1064,16 @@ static void render_particle_generator(particle_generator* pg, const mat4 v, cons
 
     // bind sprite
     if (strlen(pg->pc.sprite_path) > 0) {
+      int layer;
       glUniform1i(glGetUniformLocation(renderer_particle_shader, "sprite"), 0);
       glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, pg->sprite_id);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, texture_streamer_array(pg->sprite_id, &layer));
+      glUniform1i(glGetUniformLocation(renderer_particle_shader, "sprite_layer"), layer);
       glUniform1i(glGetUniformLocation(renderer_particle_shader, "has_sprite"), 1);
+      renderer_texture_binds++;
+
+      // sprites are small on screen and cheap, they get their whole chain
+      texture_streamer_request(pg->sprite_id, 0.0f);
     } else {
       glUniform1i(glGetUniformLocation(renderer_particle_shader, "has_sprite"), 0);
     }
@@ -851,7 +1100,15 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
 {
   GLint time;
 
-  float ratio = width / (float)height;
+  // textures requested since the last frame, and the mip levels the last frame asked for
+  texture_loader_upload();
+  texture_streamer_update();
+
+  // arrays may have been rebuilt, and other code binds to the same units
+  memset(bound_arrays, 0, sizeof(bound_arrays));
+  renderer_texture_binds = 0;
+  memset(renderer_lod_triangles, 0, sizeof(renderer_lod_triangles));
+  memset(renderer_shadow_lod_triangles, 0, sizeof(renderer_shadow_lod_triangles));
 
   // reset world transform calculations
   for (int i = 0; i < objects_length; i++) {
@@ -871,6 +1128,10 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
     calculate_world_transform(screen_objects[i]);
   }
 
+  // every pass draws in material order, the depth test makes it free
+  sort_by_material(objects, objects_length);
+  objects = sort_objects;
+
   /*-------------------------------------------------------------------------------*/
   /*------------------------------directional shadows------------------------------*/
   /*-------------------------------------------------------------------------------*/
@@ -882,18 +1143,8 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
     glClearColor(183.0f / 255.0f, 220.0f / 255.0f, 244.0f / 255.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    mat4 light_proj, light_view, light_space;
-    mat4_ortho(light_proj, -renderer_shadow_size, renderer_shadow_size, -renderer_shadow_size, renderer_shadow_size, renderer_shadow_near, renderer_shadow_far);
-    vec3 up = { 0.0f, 0.0f, 1.0f };
-
-    // move directional light with camera
-    vec3 light_cam_pos;
-    light_cam_pos[0] = camera->pos[0] + lights[l]->position[0];
-    light_cam_pos[1] = lights[l]->position[1];
-    light_cam_pos[2] = camera->pos[2] + lights[l]->position[2];
-
-    mat4_look_at(light_view, light_cam_pos, lights[l]->dir, up);
-    mat4_mul(light_space, light_proj, light_view);
+    mat4 light_space;
+    directional_light_space(camera, lights[l], light_space);
 
     // render scene from light's point of view
     glUseProgram(renderer_shadow_shader);
@@ -906,7 +1157,8 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
     glBindFramebuffer(GL_FRAMEBUFFER, renderer_depth_fbo);
     glClear(GL_DEPTH_BUFFER_BIT);
     // glCullFace(GL_FRONT);
-    render_objects(objects, objects_length, renderer_shadow_shader);
+    lod_view shadow_view = { { 0.0f, 0.0f, 0.0f }, 1, SHADOW_WIDTH / (2.0f * renderer_shadow_size), renderer_shadow_lod_pixels, renderer_shadow_lod_triangles };
+    render_objects(objects, objects_length, renderer_shadow_shader, &shadow_view);
     // glCullFace(GL_BACK);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
   }
@@ -915,7 +1167,7 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
   /*------------------------------omnidirectional shadows------------------------------*/
   /*-----------------------------------------------------------------------------------*/
   float omni_shadows_near_plane = 1.0f;
-  float omni_shadows_far_plane = 25.0f;
+  float omni_shadows_far_plane = OMNI_SHADOWS_FAR_PLANE;
 
   int omni_light_count = 0;
   for (int l = 0; l < lights_length; l++) {
@@ -948,7 +1200,9 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
     glUniform1f(glGetUniformLocation(renderer_omni_shadow_shader, "far_plane"), omni_shadows_far_plane);
     glUniform3fv(glGetUniformLocation(renderer_omni_shadow_shader, "light_pos"), 1, lights[l]->position);
 
-    render_objects(objects, objects_length, renderer_omni_shadow_shader);
+    lod_view omni_view = { { 0.0f, 0.0f, 0.0f }, 0, SHADOW_WIDTH / 2.0f, renderer_shadow_lod_pixels, renderer_shadow_lod_triangles };
+    vec3_copy(omni_view.eye, lights[l]->position);
+    render_objects(objects, objects_length, renderer_omni_shadow_shader, &omni_view);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -969,22 +1223,30 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
 
   // compute mvp matrix
   mat4 v, p;
-  vec3 camera_dir;
-  vec3_add(camera_dir, camera->pos, camera->front);
-  mat4_look_at(v, camera->pos, camera_dir, camera->up);
-  mat4_perspective(p, to_radians(45.0f), ratio, 0.1f, 100.0f);
+  camera_matrices(width, height, camera, v, p);
 
   // pass mvp to shader
   glUniformMatrix4fv(glGetUniformLocation(renderer_geometry_shader, "V"), 1, GL_FALSE, (const GLfloat*) v);
   glUniformMatrix4fv(glGetUniformLocation(renderer_geometry_shader, "P"), 1, GL_FALSE, (const GLfloat*) p);
 
-  render_objects(objects, objects_length, renderer_geometry_shader);
+  // pixels per world unit at distance 1, for a 45 degree vertical fov
+  lod_view camera_view = { { 0.0f, 0.0f, 0.0f }, 0, height / (2.0f * tanf(to_radians(45.0f) / 2.0f)), renderer_lod_pixels, renderer_lod_triangles };
+  vec3_copy(camera_view.eye, camera->pos);
+  render_objects(objects, objects_length, renderer_geometry_shader, &camera_view);
+  request_texture_levels(objects, objects_length, camera->pos, camera->front, height);
 
   // render screen objects
   mat4 screen_v;
   mat4_identity(screen_v);
   glUniformMatrix4fv(glGetUniformLocation(renderer_geometry_shader, "V"), 1, GL_FALSE, (const GLfloat*) screen_v);
-  render_objects(screen_objects, screen_objects_length, renderer_geometry_shader);
+
+  // screen objects are placed in view space
+  vec3 screen_eye = { 0.0f, 0.0f, 0.0f };
+  vec3 screen_front = { 0.0f, 0.0f, -1.0f };
+  lod_view screen_view = camera_view;
+  vec3_copy(screen_view.eye, screen_eye);
+  render_objects(screen_objects, screen_objects_length, renderer_geometry_shader, &screen_view);
+  request_texture_levels(screen_objects, screen_objects_length, screen_eye, screen_front, height);
 
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -1184,6 +1446,32 @@ void renderer_render_objects(int width, int height, object* objects[], int objec
   set_opengl_state();
 }
 
+void renderer_animator_view(int width, int height, camera* camera, light* lights[], int lights_length, animator_view* view) {
+  mat4 v, p;
+  camera_matrices(width, height, camera, v, p);
+  mat4_mul(view->camera, p, v);
+  vec3_copy(view->eye, camera->pos);
+  view->pixels = height / (2.0f * tanf(to_radians(45.0f) / 2.0f));
+
+  // the volumes the shadow passes draw, as renderer_render_objects picks them
+  view->shadow_count = 0;
+  int omni_light_count = 0;
+  for (int l = 0; l < lights_length; l++) {
+    assert(view->shadow_count < ANIMATOR_MAX_SHADOWS);
+    if (lights[l]->type == DIRECTIONAL) {
+      directional_light_space(camera, lights[l], view->shadows[view->shadow_count++]);
+    } else if (lights[l]->type == POINT && omni_light_count < MAX_OMNI_SHADOWS) {
+      // the cube map sees everything up to its far plane, a box around the light
+      mat4 box, translation;
+      float far = OMNI_SHADOWS_FAR_PLANE;
+      mat4_ortho(box, -far, far, -far, far, -far, far);
+      mat4_translate(translation, -lights[l]->position[0], -lights[l]->position[1], -lights[l]->position[2]);
+      mat4_mul(view->shadows[view->shadow_count++], box, translation);
+      omni_light_count++;
+    }
+  }
+}
+
 ray renderer_raycast(int width, int height, camera* camera, float x, float y, float ray_len) {
   float ratio = width / (float)height;
 
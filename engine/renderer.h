@@ -6,11 +6,14 @@
 #include "skybox.h"
 #include "random.h"
 #include "particle_generator.h"
+#include "texture_loader.h"
+#include "texture_cache.h"
 #include "data/object.h"
 #include "data/light.h"
 #include "data/camera.h"
 #include "data/ray.h"
 #include "data/frame.h"
+#include "animator.h"
 
 extern GLuint renderer_ssao_enabled;
 extern int renderer_ssao_debug_on;
@@ -18,6 +21,11 @@ extern int renderer_fxaa_enabled;
 extern int renderer_shadows_debug_enabled;
 extern int renderer_render_aabb;
 extern int renderer_shadow_pcf_enabled;
+extern int renderer_texture_binds;
+extern float renderer_lod_pixels;
+extern float renderer_shadow_lod_pixels;
+extern int renderer_lod_triangles[MESH_MAX_LODS];
+extern int renderer_shadow_lod_triangles[MESH_MAX_LODS];
 
 int renderer_init(int width, int height);
 void renderer_free();
@@ -28,6 +36,10 @@ void renderer_init_particle_generator(particle_generator* pg);
 void renderer_free_particle_generator(particle_generator* pg);
 void renderer_render_objects(int width, int height, object* objects[], int objects_length, object* screen_objects[], int screen_objects_length, light* lights[], int lights_length, camera* camera, void (*ui_render_callback)(void), skybox* sky, particle_generator* particle_generators[], int particle_generators_length);
 
+// where renderer_render_objects, given the same camera and lights, sees
+// objects from (for animator_schedule)
+void renderer_animator_view(int width, int height, camera* camera, light* lights[], int lights_length, animator_view* view);
+
 ray renderer_raycast(int width, int height, camera* camera, float x, float y, float ray_len);
 
 #endif
@@ -4,10 +4,12 @@
 #include "shader.h"
 #include "renderer.h"
 #include "importer.h"
+#include "asset_cache.h"
 #include "physics.h"
 #include "audio.h"
 #include "render_list.h"
 #include "factory.h"
 #include "skybox.h"
 #include "animator.h"
+#include "pose_kernels.h"
 #include "random.h"
@@ -9,13 +9,14 @@ in vec3 FragPos;
 in vec3 Normal;
 in mat3 TBN;
 
-uniform sampler2D texture_diffuse;
-uniform sampler2D texture_normal;
-uniform sampler2D texture_specular;
+// maps are layers of texture arrays, a layer of -1 means the material has none
+uniform sampler2DArray texture_diffuse;
+uniform sampler2DArray texture_normal;
+uniform sampler2DArray texture_specular;
 
-uniform int has_diffuse_map;
-uniform int has_normal_map;
-uniform int has_specular_map;
+uniform int diffuse_layer;
+uniform int normal_layer;
+uniform int specular_layer;
 
 uniform int texture_subdivision;
 
@@ -31,11 +32,12 @@ uniform Material material;
 
 vec3 compute_normal()
 {
-  // obtain normal from normal map in range [0,1]
-  vec3 normal = texture(texture_normal, TexCoords * texture_subdivision).rgb;
+  // obtain normal from normal map in range [0,1], only x and y are read
+  // since bc5 compressed maps have no z
+  vec2 xy = texture(texture_normal, vec3(TexCoords * texture_subdivision, normal_layer)).rg * 2.0 - 1.0;
 
-  // transform normal vector to range [-1,1]
-  normal = normalize(normal * 2.0 - 1.0);  // this normal is in tangent space
+  // this normal is in tangent space, z points out of the surface
+  vec3 normal = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
 
   return TBN * normal;
 }
@@ -48,17 +50,17 @@ void main() {
   gPosition.a = receive_shadows;
 
   // also store the per-fragment normals into the gbuffer
-  gNormal = has_normal_map == 1 ? compute_normal() : normalize(Normal);
+  gNormal = normal_layer >= 0 ? compute_normal() : normalize(Normal);
   // and the diffuse per-fragment color
-  gAlbedo = has_diffuse_map == 1 ? texture(texture_diffuse, TexCoords * texture_subdivision).rgba : vec4(material.diffuse.rgb, 1.0);
+  gAlbedo = diffuse_layer >= 0 ? texture(texture_diffuse, vec3(TexCoords * texture_subdivision, diffuse_layer)).rgba : vec4(material.diffuse.rgb, 1.0);
   gAlbedo.rgb *= material.diffuse;
 
   if (gAlbedo.a < 0.1)
     discard;
 
   gSpec = material.specular;
-  if (has_specular_map > 0) {
-    gSpec *= texture(texture_specular, TexCoords * texture_subdivision).r;
+  if (specular_layer >= 0) {
+    gSpec *= texture(texture_specular, vec3(TexCoords * texture_subdivision, specular_layer)).r;
   }
 
 }
@@ -6,8 +6,8 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aUvs;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aJointIds;
-layout (location = 5) in vec3 aWeights;
+layout (location = 4) in uvec4 aJointIds;
+layout (location = 5) in vec4 aWeights;
 
 out vec3 FragPos;
 out vec2 TexCoords;
@@ -20,15 +20,15 @@ uniform mat4 M;
 uniform mat4 V;
 uniform mat4 P;
 
-uniform int has_normal_map;
+uniform int normal_layer;
 
 uniform mat4 bone_transforms[MAX_BONES];
 uniform int has_skeleton;
 
 mat4 bone_transform() {
-  return aWeights.x * bone_transforms[int(aJointIds.x)]
-       + aWeights.y * bone_transforms[int(aJointIds.y)]
-       + aWeights.z * bone_transforms[int(aJointIds.z)];
+  return aWeights.x * bone_transforms[aJointIds.x]
+       + aWeights.y * bone_transforms[aJointIds.y]
+       + aWeights.z * bone_transforms[aJointIds.z];
 }
 
 void main()
@@ -43,7 +43,7 @@ void main()
   Normal = normal_matrix * (vec4(aNormal, 1.0)).xyz;
 
   // normal map
-  if (has_normal_map > 0) {
+  if (normal_layer >= 0) {
     vec3 T = normalize(normal_matrix * aTangent);
     vec3 N = normalize(normal_matrix * aNormal);
     T = normalize(T - dot(T, N) * N);
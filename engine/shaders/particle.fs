@@ -6,11 +6,12 @@ out vec4 color;
 
 uniform mat4 view;
 uniform int has_sprite;
-uniform sampler2D sprite;
+uniform sampler2DArray sprite;
+uniform int sprite_layer;
 
 void main() {
   if (has_sprite > 0) {
-    color = texture(sprite, tex_coords) * particle_color;
+    color = texture(sprite, vec3(tex_coords, sprite_layer)) * particle_color;
     color.a = particle_color.a;
   } else {
     color = particle_color;
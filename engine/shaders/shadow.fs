@@ -3,11 +3,12 @@
 in vec2 Uvs;
 
 // mask map
-uniform sampler2D texture_diffuse;
+uniform sampler2DArray texture_diffuse;
+uniform int diffuse_layer;
 
 void main() {             
   // mask map
-  vec4 alpha = texture(texture_diffuse, Uvs).rgba;
+  vec4 alpha = diffuse_layer >= 0 ? texture(texture_diffuse, vec3(Uvs, diffuse_layer)).rgba : vec4(1.0);
   if (alpha.a < 0.1) {
     discard;
   }
@@ -6,8 +6,8 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aUvs;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aJointIds;
-layout (location = 5) in vec3 aWeights;
+layout (location = 4) in uvec4 aJointIds;
+layout (location = 5) in vec4 aWeights;
 
 uniform mat4 bone_transforms[MAX_BONES];
 uniform int has_skeleton;
@@ -18,9 +18,9 @@ uniform mat4 M;
 out vec2 Uvs;
 
 mat4 bone_transform() {
-  return aWeights.x * bone_transforms[int(aJointIds.x)]
-       + aWeights.y * bone_transforms[int(aJointIds.y)]
-       + aWeights.z * bone_transforms[int(aJointIds.z)];
+  return aWeights.x * bone_transforms[aJointIds.x]
+       + aWeights.y * bone_transforms[aJointIds.y]
+       + aWeights.z * bone_transforms[aJointIds.z];
 }
 
 void main() {
@@ -6,8 +6,8 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aUvs;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aJointIds;
-layout (location = 5) in vec3 aWeights;
+layout (location = 4) in uvec4 aJointIds;
+layout (location = 5) in vec4 aWeights;
 
 out vec3 FragPos;
 out vec2 Uvs;
@@ -34,9 +34,9 @@ uniform vec3 lightsPos[NR_LIGHTS];
 uniform int hasNormalMap;
 
 mat4 boneTransform() {
-  return aWeights.x * bone_world_matrices[int(aJointIds.x)]
-       + aWeights.y * bone_world_matrices[int(aJointIds.y)]
-       + aWeights.z * bone_world_matrices[int(aJointIds.z)];
+  return aWeights.x * bone_world_matrices[aJointIds.x]
+       + aWeights.y * bone_world_matrices[aJointIds.y]
+       + aWeights.z * bone_world_matrices[aJointIds.z];
 }
 
 void main() {
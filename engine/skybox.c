@@ -64,7 +64,12 @@ static unsigned int load_cubemap(const char* faces[])
   stbi_set_flip_vertically_on_load(false);
   for (unsigned int i = 0; i < 6; i++)
   {
-    unsigned char *data = stbi_load(faces[i], &width, &height, &nrChannels, 0);
+    vfs_file file;
+    unsigned char *data = NULL;
+    if (vfs_open(faces[i], &file)) {
+      data = stbi_load_from_memory((stbi_uc*)file.data, file.size, &width, &height, &nrChannels, 0);
+      vfs_close(&file);
+    }
     if (data)
     {
       glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
@@ -0,0 +1,211 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stex.h"
+
+void stex_path(const char* path, char* out) {
+  strcpy(out, path);
+  char* dot = strrchr(out, '.');
+  char* slash = strrchr(out, '/');
+  if (dot == NULL || (slash != NULL && dot < slash)) {
+    dot = out + strlen(out);
+  }
+  strcpy(dot, ".stex");
+}
+
+void stex_flip_rows(unsigned char* pixels, int width, int height, int channels) {
+  size_t row_size = (size_t)width * channels;
+  unsigned char* row = malloc(row_size);
+  for (int y = 0; y < height / 2; y++) {
+    unsigned char* top = pixels + y * row_size;
+    unsigned char* bottom = pixels + (height - 1 - y) * row_size;
+    memcpy(row, top, row_size);
+    memcpy(top, bottom, row_size);
+    memcpy(bottom, row, row_size);
+  }
+  free(row);
+}
+
+// name_normal.png, name_norm.png, name_nrm.png, name_nml.png or name_n.png,
+// the tag as a whole word between underscores (rock_nml_2.png as well)
+int stex_is_normal_map(const char* path) {
+  const char* slash = strrchr(path, '/');
+  char name[256];
+  snprintf(name, sizeof(name), "%s", slash ? slash + 1 : path);
+  for (char* c = name; *c; c++) {
+    *c = tolower(*c);
+  }
+
+  char* dot = strrchr(name, '.');
+  if (dot != NULL) *dot = '\0';
+
+  static const char* tags[4] = { "normal", "norm", "nrm", "nml" };
+  char* word = name;
+  for (;;) {
+    char* end = strchr(word, '_');
+    size_t len = end != NULL ? (size_t)(end - word) : strlen(word);
+    for (int i = 0; i < 4; i++) {
+      if (len == strlen(tags[i]) && strncmp(word, tags[i], len) == 0) return 1;
+    }
+
+    // a lone n only after the name
+    if (end == NULL) return word != name && len == 1 && word[0] == 'n';
+    word = end + 1;
+  }
+}
+
+static int has_alpha(const unsigned char* rgba, int width, int height) {
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    if (rgba[i * 4 + 3] != 255) return 1;
+  }
+  return 0;
+}
+
+// next mip level, each pixel averages a 2x2 square (normals are renormalized)
+static unsigned char* downsample(const unsigned char* src, int width, int height, int normal_map) {
+  int w = width > 1 ? width / 2 : 1;
+  int h = height > 1 ? height / 2 : 1;
+  unsigned char* dst = malloc((size_t)w * h * 4);
+
+  for (int y = 0; y < h; y++) {
+    int y0 = 2 * y < height ? 2 * y : height - 1;
+    int y1 = 2 * y + 1 < height ? 2 * y + 1 : height - 1;
+    for (int x = 0; x < w; x++) {
+      int x0 = 2 * x < width ? 2 * x : width - 1;
+      int x1 = 2 * x + 1 < width ? 2 * x + 1 : width - 1;
+      const unsigned char* p[4] = {
+        src + ((size_t)y0 * width + x0) * 4, src + ((size_t)y0 * width + x1) * 4,
+        src + ((size_t)y1 * width + x0) * 4, src + ((size_t)y1 * width + x1) * 4
+      };
+      unsigned char* out = dst + ((size_t)y * w + x) * 4;
+
+      for (int k = 0; k < 4; k++) {
+        out[k] = (p[0][k] + p[1][k] + p[2][k] + p[3][k] + 2) / 4;
+      }
+
+      if (normal_map) {
+        vec3 n = { 0, 0, 0 };
+        for (int i = 0; i < 4; i++) {
+          for (int k = 0; k < 3; k++) n[k] += p[i][k] / 127.5f - 1.0f;
+        }
+        if (vec3_len(n) > 1e-6f) {
+          vec3_norm(n, n);
+          for (int k = 0; k < 3; k++) out[k] = (unsigned char)((n[k] + 1.0f) * 127.5f + 0.5f);
+        }
+      }
+    }
+  }
+  return dst;
+}
+
+int stex_bake(const char* path, const char* out_path) {
+  vfs_file file;
+  if (!vfs_open(path, &file)) {
+    printf("[stex] cannot read %s\n", path);
+    return 0;
+  }
+
+  int width, height, channels;
+  unsigned char* pixels = stbi_load_from_memory((stbi_uc*)file.data, file.size, &width, &height, &channels, 4);
+  vfs_close(&file);
+  if (pixels == NULL) {
+    printf("[stex] cannot decode %s\n", path);
+    return 0;
+  }
+  stex_flip_rows(pixels, width, height, 4);
+
+  bcn_format format = BCN_BC1;
+  if (stex_is_normal_map(path)) {
+    format = BCN_BC5;
+  } else if ((channels == 2 || channels == 4) && has_alpha(pixels, width, height)) {
+    format = BCN_BC3;
+  }
+
+  stex_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "STEX", 4);
+  h.version = STEX_VERSION;
+  h.format = format;
+  h.width = width;
+  h.height = height;
+  if (!vfs_stat(path, &h.source_mtime, &h.source_size)) {
+    h.source_mtime = h.source_size = -1;
+  }
+
+  FILE* out = fopen(out_path, "wb");
+  if (out == NULL) {
+    printf("[stex] cannot write %s\n", out_path);
+    stbi_image_free(pixels);
+    return 0;
+  }
+
+  // levels are 16 byte aligned after the header
+  char pad[16] = { 0 };
+  long long offset = (sizeof(h) + 15) & ~15LL;
+  fwrite(&h, sizeof(h), 1, out);
+  fwrite(pad, 1, offset - sizeof(h), out);
+
+  unsigned char* level = pixels;
+  int w = width, lh = height;
+  while (1) {
+    int size = bcn_size(format, w, lh);
+    unsigned char* blocks = malloc(size);
+    bcn_compress(format, level, w, lh, blocks);
+    fwrite(blocks, 1, size, out);
+    free(blocks);
+
+    h.level_offset[h.level_count] = offset;
+    h.level_size[h.level_count] = size;
+    h.level_count++;
+    offset += size;
+    long long aligned = (offset + 15) & ~15LL;
+    fwrite(pad, 1, aligned - offset, out);
+    offset = aligned;
+
+    if ((w == 1 && lh == 1) || h.level_count == STEX_MAX_LEVELS) break;
+
+    unsigned char* next = downsample(level, w, lh, format == BCN_BC5);
+    if (level != pixels) free(level);
+    level = next;
+    w = w > 1 ? w / 2 : 1;
+    lh = lh > 1 ? lh / 2 : 1;
+  }
+  if (level != pixels) free(level);
+  stbi_image_free(pixels);
+
+  fseek(out, 0, SEEK_SET);
+  fwrite(&h, sizeof(h), 1, out);
+  int ok = ferror(out) == 0;
+  fclose(out);
+
+  printf("[stex] baked %s (bc%d %dx%d, %d levels, %.2f MB)\n", out_path, format, width, height, h.level_count, offset / 1048576.0);
+  return ok;
+}
+
+const stex_header* stex_check(const char* data, size_t size, const char* source) {
+  if (size < sizeof(stex_header)) {
+    return NULL;
+  }
+
+  const stex_header* h = (const stex_header*)data;
+  if (memcmp(h->magic, "STEX", 4) != 0 || h->version != STEX_VERSION ||
+      (h->format != BCN_BC1 && h->format != BCN_BC3 && h->format != BCN_BC5) ||
+      h->level_count < 1 || h->level_count > STEX_MAX_LEVELS) {
+    return NULL;
+  }
+
+  for (int l = 0; l < h->level_count; l++) {
+    int w = h->width >> l > 0 ? h->width >> l : 1;
+    int lh = h->height >> l > 0 ? h->height >> l : 1;
+    if (h->level_size[l] != bcn_size(h->format, w, lh) || h->level_offset[l] < 0 ||
+        h->level_offset[l] + h->level_size[l] > (long long)size) {
+      return NULL;
+    }
+  }
+
+  // the source is not needed, but a newer one wins
+  long long source_mtime, source_size;
+  if (vfs_stat(source, &source_mtime, &source_size) &&
+      (source_mtime != h->source_mtime || source_size != h->source_size)) {
+    return NULL;
+  }
+  return h;
+}
@@ -0,0 +1,43 @@
+#ifndef stex_h
+#define stex_h
+
+#include "engine.h"
+#include "bcn.h"
+
+// bump when the .stex layout or the encoder output changes
+#define STEX_VERSION 2
+#define STEX_MAX_LEVELS 16
+
+/* baked texture: header, then the whole mip chain from the full size down to
+   1x1, block compressed and already flipped for opengl */
+typedef struct {
+  char magic[4];
+  int version;
+  int format;   // bcn_format
+  int width;
+  int height;
+  int level_count;
+  long long source_mtime;   // of the image it was baked from
+  long long source_size;
+  long long level_offset[STEX_MAX_LEVELS];
+  int level_size[STEX_MAX_LEVELS];
+} stex_header;
+
+// the baked file of an image: dir/name.png -> dir/name.stex
+void stex_path(const char* path, char* out);
+
+// reverses the row order, opengl wants the bottom row first
+void stex_flip_rows(unsigned char* pixels, int width, int height, int channels);
+
+// whether the image is a normal map by its file name: normal, norm, nrm or
+// nml as a word between underscores, or a trailing _n
+int stex_is_normal_map(const char* path);
+
+// decodes the image and writes its mip chain to out_path: bc5 for normal maps
+// (by file name), bc3 for images with transparent pixels and bc1 otherwise
+int stex_bake(const char* path, const char* out_path);
+
+// header of a baked file that is complete and as new as its source, else NULL
+const stex_header* stex_check(const char* data, size_t size, const char* source);
+
+#endif
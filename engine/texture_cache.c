@@ -0,0 +1,163 @@
+#include "texture_cache.h"
+
+int texture_cache_hits = 0;
+
+static texture_cache_entry entries[TEXTURE_CACHE_SIZE];
+
+// drops "." and empty components and resolves "..", so equal files share one key
+// (absolute paths keep their leading slash, ".." stops at the root)
+static void normalize_path(const char* path, char* out) {
+  char parts[64][256];
+  int count = 0;
+  int absolute = path[0] == '/';
+
+  const char* p = path;
+  while (*p) {
+    const char* end = strchr(p, '/');
+    int len = end ? end - p : (int)strlen(p);
+
+    if (len == 2 && strncmp(p, "..", 2) == 0 && count > 0 && strcmp(parts[count - 1], "..") != 0) {
+      count--;
+    } else if (len == 2 && strncmp(p, "..", 2) == 0 && count == 0 && absolute) {
+      // nothing above the root
+    } else if (len > 0 && !(len == 1 && p[0] == '.') && count < 64) {
+      memcpy(parts[count], p, len);
+      parts[count++][len] = '\0';
+    }
+
+    p += len;
+    if (*p == '/') p++;
+  }
+
+  strcpy(out, absolute ? "/" : "");
+  for (int i = 0; i < count; i++) {
+    if (i > 0) strcat(out, "/");
+    strcat(out, parts[i]);
+  }
+}
+
+static texture_cache_entry* find_entry(const char* path) {
+  for (int i = 0; i < TEXTURE_CACHE_SIZE; i++) {
+    if (entries[i].refs > 0 && strcmp(entries[i].path, path) == 0) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+
+// level 0 size of an uploaded texture, plus a third for its mipmaps
+static long long texture_bytes(GLuint texture) {
+  GLint width = 0, height = 0, format = 0, compressed = 0;
+  int layer;
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture_streamer_array(texture, &layer));
+
+  // baked textures come with their mip chain, without the fine levels that
+  // are not resident, and share it with the other layers of their pool
+  GLint base = 0, layers = 1;
+  glGetTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, &base);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, base, GL_TEXTURE_COMPRESSED, &compressed);
+  if (compressed) {
+    long long bytes = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, base, GL_TEXTURE_DEPTH, &layers);
+    for (int level = base; level < STEX_MAX_LEVELS; level++) {
+      GLint size = 0;
+      glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, level, GL_TEXTURE_WIDTH, &width);
+      if (width == 0) break;
+      glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+      bytes += size;
+    }
+    return bytes / layers;
+  }
+
+  glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &width);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &height);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+
+  int channels = 4;
+  if (format == GL_RED || format == GL_R8) channels = 1;
+  else if (format == GL_RG || format == GL_RG8 || format == GL_ALPHA) channels = 2;
+  else if (format == GL_RGB || format == GL_RGB8) channels = 3;
+
+  return (long long)width * height * channels * 4 / 3;
+}
+
+// texture name of the file, decoded on first use
+GLuint texture_cache_load(const char* path) {
+  if (strlen(path) == 0) {
+    return 0;
+  }
+
+  char key[256];
+  normalize_path(path, key);
+
+  texture_cache_entry* e = find_entry(key);
+  if (e != NULL) {
+    e->refs++;
+    texture_cache_hits++;
+    return e->texture;
+  }
+
+  for (int i = 0; i < TEXTURE_CACHE_SIZE; i++) {
+    e = &entries[i];
+    if (e->refs == 0) {
+      strcpy(e->path, key);
+      e->texture = texture_loader_load(key);
+      e->refs = 1;
+      return e->texture;
+    }
+  }
+
+  printf("[texture_cache] cache is full, cannot add %s\n", key);
+  exit(1);
+}
+
+// deletes the texture once its last user is gone
+void texture_cache_release(GLuint texture) {
+  if (texture == 0) {
+    return;
+  }
+
+  for (int i = 0; i < TEXTURE_CACHE_SIZE; i++) {
+    texture_cache_entry* e = &entries[i];
+    if (e->refs > 0 && e->texture == texture) {
+      e->refs--;
+      if (e->refs == 0) {
+        texture_loader_cancel(e->texture);
+        texture_streamer_remove(e->texture);
+        glDeleteTextures(1, &e->texture);
+      }
+      return;
+    }
+  }
+}
+
+// call once the loader finished, sizes come from the uploaded textures
+void texture_cache_report() {
+  int textures = 0;
+  long long total_bytes = 0;
+  long long saved_bytes = 0;
+  for (int i = 0; i < TEXTURE_CACHE_SIZE; i++) {
+    texture_cache_entry* e = &entries[i];
+    if (e->refs > 0) {
+      long long bytes = texture_bytes(e->texture);
+      textures++;
+      total_bytes += bytes;
+      saved_bytes += bytes * (e->refs - 1);
+    }
+  }
+
+  printf("[texture_cache] %d textures (%.1f MB), %d decodes avoided, %.1f MB vram saved\n",
+      textures, total_bytes / 1048576.0, texture_cache_hits, saved_bytes / 1048576.0);
+}
+
+void texture_cache_free() {
+  for (int i = 0; i < TEXTURE_CACHE_SIZE; i++) {
+    texture_cache_entry* e = &entries[i];
+    if (e->refs > 0) {
+      texture_loader_cancel(e->texture);
+      texture_streamer_remove(e->texture);
+      glDeleteTextures(1, &e->texture);
+      e->refs = 0;
+    }
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef texture_cache_h
+#define texture_cache_h
+
+#include "engine.h"
+#include "texture_loader.h"
+
+#define TEXTURE_CACHE_SIZE 256
+
+// textures are decoded and uploaded once per file, then shared by every material using them
+typedef struct {
+  char path[256];
+  GLuint texture;
+  int refs;
+} texture_cache_entry;
+
+// loads served from the cache instead of a new decode and upload
+extern int texture_cache_hits;
+
+GLuint texture_cache_load(const char* path);
+void texture_cache_release(GLuint texture);
+void texture_cache_report();
+void texture_cache_free();
+
+#endif
@@ -0,0 +1,263 @@
+#include "texture_loader.h"
+
+int texture_loader_threads = 0;
+int texture_loader_compressed = 1;
+
+// formats the driver takes, rgtc (bc5) is core since 3.0
+static int s3tc_supported = 0;
+
+// requests in [done, tail) are not uploaded yet, the workers take them from head
+static texture_request requests[TEXTURE_LOADER_QUEUE_SIZE];
+static int head = 0;
+static int tail = 0;
+static int done = 0;
+static int decoded_count = 0;
+
+static pthread_t threads[TEXTURE_LOADER_MAX_THREADS];
+static int thread_count = 0;
+static int quit = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t decoded = PTHREAD_COND_INITIALIZER;
+
+static texture_request* request_at(int i) {
+  return &requests[i % TEXTURE_LOADER_QUEUE_SIZE];
+}
+
+static int has_extension(const char* name) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (int i = 0; i < count; i++) {
+    if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int format_supported(int format) {
+  return format == BCN_BC5 || s3tc_supported;
+}
+
+// the baked mip chain when there is an up to date one the driver can take
+static int open_baked(texture_request* r) {
+  char path[256];
+  stex_path(r->path, path);
+  if (!texture_loader_compressed || !vfs_open(path, &r->baked)) {
+    return 0;
+  }
+
+  const stex_header* h = stex_check(r->baked.data, r->baked.size, r->path);
+  if (h == NULL || !format_supported(h->format)) {
+    vfs_close(&r->baked);
+    return 0;
+  }
+  return 1;
+}
+
+static void decode(texture_request* r) {
+  r->pixels = NULL;
+  r->compressed = open_baked(r);
+  if (r->compressed) {
+    return;
+  }
+
+  // read through the vfs (asset pack or loose file)
+  vfs_file file;
+  if (vfs_open(r->path, &file)) {
+    r->pixels = stbi_load_from_memory((stbi_uc*)file.data, file.size, &r->width, &r->height, &r->channels, 0);
+    vfs_close(&file);
+  }
+
+  // stb_image's flip flag is global, so every worker flips its own rows
+  if (r->pixels) {
+    stex_flip_rows(r->pixels, r->width, r->height, r->channels);
+  }
+}
+
+static void* worker(void* arg) {
+  pthread_mutex_lock(&lock);
+  while (1) {
+    while (!quit && head == tail) {
+      pthread_cond_wait(&work_ready, &lock);
+    }
+    if (quit) break;
+
+    texture_request* r = request_at(head++);
+    r->state = TEXTURE_DECODING;
+    pthread_mutex_unlock(&lock);
+
+    decode(r);
+
+    pthread_mutex_lock(&lock);
+    r->state = TEXTURE_DECODED;
+    decoded_count++;
+    pthread_cond_signal(&decoded);
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+static void start_threads() {
+  int count = texture_loader_threads > 0 ? texture_loader_threads : sysconf(_SC_NPROCESSORS_ONLN);
+  if (count < 1) count = 1;
+  if (count > TEXTURE_LOADER_MAX_THREADS) count = TEXTURE_LOADER_MAX_THREADS;
+
+  s3tc_supported = has_extension("GL_EXT_texture_compression_s3tc");
+
+  quit = 0;
+  for (thread_count = 0; thread_count < count; thread_count++) {
+    if (pthread_create(&threads[thread_count], NULL, worker, NULL) != 0) {
+      printf("[texture_loader] cannot create worker thread\n");
+      exit(1);
+    }
+  }
+}
+
+// an array of one layer, so every texture is sampled the same way as the pooled ones
+static void upload_pixels(texture_request* r) {
+  GLenum format;
+  if (r->channels == 1)
+    format = GL_RED;
+  if (r->channels == 2)
+    format = GL_ALPHA;
+  else if (r->channels == 3)
+    format = GL_RGB;
+  else if (r->channels == 4)
+    format = GL_RGBA;
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, r->texture);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, r->width, r->height, 1, 0, format, GL_UNSIGNED_BYTE, r->pixels);
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+static void upload(texture_request* r) {
+  // skipped if it was deleted while decoding
+  if (!r->cancelled) {
+    if (r->compressed) {
+      // the streamer keeps the baked file
+      texture_streamer_upload(r->texture, &r->baked);
+      r->compressed = 0;
+    } else if (r->pixels) {
+      upload_pixels(r);
+    } else {
+      printf("Error loading texture: %s\n", r->path);
+    }
+  }
+
+  if (r->compressed) {
+    vfs_close(&r->baked);
+  }
+  stbi_image_free(r->pixels);
+  r->pixels = NULL;
+}
+
+int texture_loader_upload() {
+  for (int i = done; i < tail; i++) {
+    texture_request* r = request_at(i);
+
+    // the workers are done with a decoded request, it is only touched here
+    pthread_mutex_lock(&lock);
+    int ready = r->state == TEXTURE_DECODED;
+    if (ready) {
+      r->state = TEXTURE_UPLOADED;
+      decoded_count--;
+    }
+    pthread_mutex_unlock(&lock);
+
+    if (ready) {
+      upload(r);
+    }
+  }
+
+  pthread_mutex_lock(&lock);
+  while (done < tail && request_at(done)->state == TEXTURE_UPLOADED) {
+    done++;
+  }
+  pthread_mutex_unlock(&lock);
+  return tail - done;
+}
+
+// blocks until at least one image is decoded (something must be queued)
+static void wait_decoded() {
+  pthread_mutex_lock(&lock);
+  while (decoded_count == 0) {
+    pthread_cond_wait(&decoded, &lock);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+GLuint texture_loader_load(const char* path) {
+  if (strlen(path) == 0) {
+    return 0;
+  }
+
+  if (thread_count == 0) {
+    start_threads();
+  }
+
+  // queue full, make room
+  while (texture_loader_upload() == TEXTURE_LOADER_QUEUE_SIZE) {
+    wait_decoded();
+  }
+
+  // baked textures are pooled by the streamer, the name is then only a handle
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  // set the texture wrapping parameters
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // set texture filtering parameters
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  texture_request* r = request_at(tail);
+  strcpy(r->path, path);
+  r->texture = texture;
+  r->pixels = NULL;
+  r->compressed = 0;
+  r->cancelled = 0;
+  r->state = TEXTURE_QUEUED;
+
+  pthread_mutex_lock(&lock);
+  tail++;
+  pthread_cond_signal(&work_ready);
+  pthread_mutex_unlock(&lock);
+
+  return texture;
+}
+
+void texture_loader_cancel(GLuint texture) {
+  for (int i = done; i < tail; i++) {
+    if (request_at(i)->texture == texture) {
+      request_at(i)->cancelled = 1;
+    }
+  }
+}
+
+void texture_loader_finish() {
+  while (texture_loader_upload() > 0) {
+    wait_decoded();
+  }
+}
+
+void texture_loader_free() {
+  texture_loader_finish();
+
+  pthread_mutex_lock(&lock);
+  quit = 1;
+  pthread_cond_broadcast(&work_ready);
+  pthread_mutex_unlock(&lock);
+
+  for (int i = 0; i < thread_count; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  thread_count = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef texture_loader_h
+#define texture_loader_h
+
+#include "engine.h"
+#include "texture_streamer.h"
+
+#define TEXTURE_LOADER_MAX_THREADS 8
+#define TEXTURE_LOADER_QUEUE_SIZE 256
+
+typedef enum {
+  TEXTURE_QUEUED,
+  TEXTURE_DECODING,
+  TEXTURE_DECODED,
+  TEXTURE_UPLOADED
+} texture_state;
+
+typedef struct {
+  char path[256];
+  GLuint texture;
+  texture_state state;
+  int cancelled;
+
+  // decoded on a worker, flipped for opengl (NULL if the image could not be read)
+  unsigned char* pixels;
+  int width;
+  int height;
+  int channels;
+
+  // or its baked .stex, uploaded as it is (compressed is 0 if there is none)
+  vfs_file baked;
+  int compressed;
+} texture_request;
+
+// decoding threads, 0 uses one per core
+extern int texture_loader_threads;
+
+// upload baked block compressed textures when the driver supports them
+extern int texture_loader_compressed;
+
+// texture name right away, the image is decoded on a worker and uploaded by
+// texture_loader_upload or texture_loader_finish on the gl thread. it names a
+// GL_TEXTURE_2D_ARRAY, or a layer of a pooled one (texture_streamer_array)
+GLuint texture_loader_load(const char* path);
+
+// uploads the images decoded so far without waiting, returns how many are left
+int texture_loader_upload();
+
+// the texture was deleted before its image was uploaded
+void texture_loader_cancel(GLuint texture);
+
+// waits for every queued image, uploading each as soon as it is decoded
+void texture_loader_finish();
+
+void texture_loader_free();
+
+#endif
@@ -0,0 +1,429 @@
+#include "texture_streamer.h"
+
+// s3tc is an extension, glad only loads core
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// bytes uploaded per frame at most, keeps a burst of requests from stalling a frame
+#define TEXTURE_STREAMER_FRAME_BYTES (4 << 20)
+
+long long texture_streamer_budget = 32 << 20;
+long long texture_streamer_resident = 0;
+int texture_streamer_enabled = 1;
+
+static texture_pool pools[TEXTURE_STREAMER_POOLS];
+static unsigned frame = 0;
+
+// pools with a level to page in, the thread reads it from the files before the gl thread uploads
+static int queue[TEXTURE_STREAMER_POOLS];
+static int queue_head = 0;
+static int queue_tail = 0;
+static int paging = -1;
+
+static pthread_t thread;
+static int thread_started = 0;
+static int quit = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t paged = PTHREAD_COND_INITIALIZER;
+
+static GLenum gl_format(int format) {
+  if (format == BCN_BC1)
+    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  if (format == BCN_BC3)
+    return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  return GL_COMPRESSED_RG_RGTC2;
+}
+
+static int level_width(texture_pool* p, int level) {
+  return p->width >> level > 0 ? p->width >> level : 1;
+}
+
+static int level_height(texture_pool* p, int level) {
+  return p->height >> level > 0 ? p->height >> level : 1;
+}
+
+// bytes of one layer's level
+static int level_size(texture_pool* p, int level) {
+  return bcn_size(p->format, level_width(p, level), level_height(p, level));
+}
+
+// bytes of the streamed levels the pool holds or is loading
+static long long pool_bytes(texture_pool* p) {
+  long long bytes = 0;
+  for (int l = p->resident; l < p->tail; l++) {
+    bytes += level_size(p, l);
+  }
+  if (p->loading >= 0) {
+    bytes += level_size(p, p->loading);
+  }
+  return bytes * p->layer_count;
+}
+
+static void count_resident() {
+  texture_streamer_resident = 0;
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    if (pools[i].texture != 0) {
+      texture_streamer_resident += pool_bytes(&pools[i]);
+    }
+  }
+}
+
+// one layer's level into the bound array, its storage must exist
+static void upload_layer(texture_pool* p, int index, int level) {
+  texture_layer* layer = &p->layers[index];
+  glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, index, level_width(p, level), level_height(p, level), 1,
+      p->gl_format, level_size(p, level), layer->baked.data + layer->header->level_offset[level]);
+}
+
+// allocates the level in the bound array and fills every layer in use
+static void upload_level(texture_pool* p, int level) {
+  int size = level_size(p, level);
+  glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, p->gl_format, level_width(p, level), level_height(p, level), p->layer_count, 0, size * p->layer_count, NULL);
+
+  for (int i = 0; i < p->layer_count; i++) {
+    if (p->layers[i].handle != 0) {
+      upload_layer(p, i, level);
+    }
+  }
+}
+
+// (re)creates the array with room for every layer and uploads the resident levels
+static void build_array(texture_pool* p) {
+  if (p->texture != 0) {
+    glDeleteTextures(1, &p->texture);
+  }
+  glGenTextures(1, &p->texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, p->texture);
+  for (int l = p->resident; l < p->level_count; l++) {
+    upload_level(p, l);
+  }
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, p->resident);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, p->level_count - 1);
+
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+static texture_pool* find(GLuint handle, int* layer) {
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    texture_pool* p = &pools[i];
+    for (int j = 0; p->texture != 0 && j < p->layer_count; j++) {
+      if (p->layers[j].handle == handle) {
+        *layer = j;
+        return p;
+      }
+    }
+  }
+  return NULL;
+}
+
+// touches every page of the level so mapped files are read here, not during the upload
+static void* pager(void* arg) {
+  pthread_mutex_lock(&lock);
+  while (1) {
+    while (!quit && queue_head == queue_tail) {
+      pthread_cond_wait(&work_ready, &lock);
+    }
+    if (quit) break;
+
+    paging = queue[queue_head++ % TEXTURE_STREAMER_POOLS];
+    texture_pool* p = &pools[paging];
+    int level = p->loading;
+    int size = level_size(p, level);
+
+    // layers are only closed once the pager left the pool
+    const char* data[TEXTURE_STREAMER_LAYERS];
+    int count = 0;
+    for (int i = 0; i < p->layer_count; i++) {
+      if (p->layers[i].handle != 0) {
+        data[count++] = p->layers[i].baked.data + p->layers[i].header->level_offset[level];
+      }
+    }
+    pthread_mutex_unlock(&lock);
+
+    volatile char sum = 0;
+    for (int i = 0; i < count; i++) {
+      for (int b = 0; b < size; b += 4096) {
+        sum += data[i][b];
+      }
+    }
+
+    pthread_mutex_lock(&lock);
+    p->ready = 1;
+    paging = -1;
+    pthread_cond_broadcast(&paged);
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+// the pool for the texture's format and size with room for it, a new one if there is none
+static texture_pool* pool_for(const stex_header* h) {
+  texture_pool* free_pool = NULL;
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    texture_pool* p = &pools[i];
+    if (p->texture == 0) {
+      if (free_pool == NULL) free_pool = p;
+      continue;
+    }
+    if (p->format == h->format && p->width == h->width && p->height == h->height && p->level_count == h->level_count) {
+      for (int j = 0; j < p->layer_count; j++) {
+        if (p->layers[j].handle == 0) return p;
+      }
+      if (p->layer_count < TEXTURE_STREAMER_LAYERS) return p;
+    }
+  }
+
+  if (free_pool == NULL) {
+    printf("[texture_streamer] too many texture pools\n");
+    exit(1);
+  }
+
+  // levels at or below the tail size go up now, the rest on request
+  int tail = 0;
+  while (texture_streamer_enabled && tail < h->level_count - 1 && (h->width >> tail > TEXTURE_STREAMER_TAIL_SIZE || h->height >> tail > TEXTURE_STREAMER_TAIL_SIZE)) {
+    tail++;
+  }
+
+  texture_pool* p = free_pool;
+  memset(p, 0, sizeof(texture_pool));
+  p->format = h->format;
+  p->width = h->width;
+  p->height = h->height;
+  p->level_count = h->level_count;
+  p->gl_format = gl_format(h->format);
+  p->tail = tail;
+  p->resident = tail;
+  p->wanted = tail;
+  p->loading = -1;
+  p->last_seen = frame;
+  return p;
+}
+
+void texture_streamer_upload(GLuint handle, vfs_file* baked) {
+  if (!thread_started) {
+    quit = 0;
+    if (pthread_create(&thread, NULL, pager, NULL) != 0) {
+      printf("[texture_streamer] cannot create paging thread\n");
+      exit(1);
+    }
+    thread_started = 1;
+  }
+
+  pthread_mutex_lock(&lock);
+  texture_pool* p = pool_for((const stex_header*)baked->data);
+
+  int index = 0;
+  while (index < p->layer_count && p->layers[index].handle != 0) {
+    index++;
+  }
+
+  texture_layer* layer = &p->layers[index];
+  layer->handle = handle;
+  layer->baked = *baked;
+  layer->header = (const stex_header*)baked->data;
+
+  if (index < p->layer_count) {
+    // a free layer of the array, only its own levels go up
+    glBindTexture(GL_TEXTURE_2D_ARRAY, p->texture);
+    for (int l = p->resident; l < p->level_count; l++) {
+      upload_layer(p, index, l);
+    }
+  } else {
+    // arrays cannot grow, the resident levels go up again with one layer more
+    p->layer_count++;
+    build_array(p);
+  }
+
+  count_resident();
+  pthread_mutex_unlock(&lock);
+}
+
+GLuint texture_streamer_array(GLuint handle, int* layer) {
+  texture_pool* p = find(handle, layer);
+  if (p == NULL) {
+    *layer = 0;
+    return handle;
+  }
+  return p->texture;
+}
+
+void texture_streamer_request(GLuint handle, float uv_per_pixel) {
+  if (handle == 0) {
+    return;
+  }
+
+  int layer;
+  texture_pool* p = find(handle, &layer);
+  if (p == NULL) {
+    return;
+  }
+
+  // one texel per pixel: level 0 has width texels across the 0..1 range
+  float texels_per_pixel = uv_per_pixel * p->width;
+  int level = texels_per_pixel > 1.0f ? (int)log2f(texels_per_pixel) : 0;
+  if (level < p->wanted) {
+    p->wanted = level;
+  }
+  p->last_seen = frame;
+}
+
+// the finest resident level goes back to the files
+static void evict_level(texture_pool* p) {
+  int level = p->resident;
+  glBindTexture(GL_TEXTURE_2D_ARRAY, p->texture);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, level + 1);
+  // an empty image frees the level's storage
+  glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, p->gl_format, 0, 0, 0, 0, 0, NULL);
+  p->resident = level + 1;
+}
+
+// least recently seen pool holding a level finer than it needs, levels
+// are only dropped from pools not streaming one in
+static texture_pool* eviction_candidate() {
+  texture_pool* best = NULL;
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    texture_pool* p = &pools[i];
+    if (p->texture != 0 && p->loading < 0 && p->resident < p->tail && p->resident < p->wanted) {
+      if (best == NULL || p->last_seen < best->last_seen) {
+        best = p;
+      }
+    }
+  }
+  return best;
+}
+
+// frees room for 'bytes' more, returns 0 if the budget cannot take them
+static int make_room(long long bytes) {
+  while (texture_streamer_resident + bytes > texture_streamer_budget) {
+    texture_pool* p = eviction_candidate();
+    if (p == NULL) {
+      return 0;
+    }
+    evict_level(p);
+    count_resident();
+  }
+  return 1;
+}
+
+void texture_streamer_update() {
+  if (!thread_started) {
+    return;
+  }
+
+  long long uploaded = 0;
+
+  pthread_mutex_lock(&lock);
+
+  // the budget may have shrunk
+  make_room(0);
+
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    texture_pool* p = &pools[i];
+    if (p->texture == 0) {
+      continue;
+    }
+
+    // levels paged in since the last frame
+    if (p->loading >= 0 && p->ready && uploaded < TEXTURE_STREAMER_FRAME_BYTES) {
+      glBindTexture(GL_TEXTURE_2D_ARRAY, p->texture);
+      upload_level(p, p->loading);
+      glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, p->loading);
+      p->resident = p->loading;
+      uploaded += (long long)level_size(p, p->loading) * p->layer_count;
+      p->loading = -1;
+      p->ready = 0;
+    }
+
+    // one level finer at a time, coarse to fine
+    if (p->loading < 0 && p->wanted < p->resident) {
+      int level = p->resident - 1;
+      // counted from here, so several levels started in one frame fit together
+      if (make_room((long long)level_size(p, level) * p->layer_count)) {
+        p->loading = level;
+        count_resident();
+        queue[queue_tail++ % TEXTURE_STREAMER_POOLS] = i;
+        pthread_cond_signal(&work_ready);
+      }
+    }
+  }
+  pthread_mutex_unlock(&lock);
+
+  // pools not seen again keep their levels until the budget needs them
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    pools[i].wanted = pools[i].tail;
+  }
+  frame++;
+}
+
+// with the lock held, closes the layer's file once the pager left the pool
+static void release_layer(texture_pool* p, int index) {
+  int slot = p - pools;
+  while (paging == slot) {
+    pthread_cond_wait(&paged, &lock);
+  }
+  vfs_close(&p->layers[index].baked);
+  memset(&p->layers[index], 0, sizeof(texture_layer));
+
+  for (int i = 0; i < p->layer_count; i++) {
+    if (p->layers[i].handle != 0) return;
+  }
+
+  // the last one deletes the array, and takes the pool off the queue before the slot is reused
+  for (int i = queue_head; i < queue_tail; i++) {
+    if (queue[i % TEXTURE_STREAMER_POOLS] == slot) {
+      for (int j = i; j + 1 < queue_tail; j++) {
+        queue[j % TEXTURE_STREAMER_POOLS] = queue[(j + 1) % TEXTURE_STREAMER_POOLS];
+      }
+      queue_tail--;
+      break;
+    }
+  }
+
+  glDeleteTextures(1, &p->texture);
+  memset(p, 0, sizeof(texture_pool));
+}
+
+void texture_streamer_remove(GLuint handle) {
+  if (handle == 0 || !thread_started) {
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  int layer;
+  texture_pool* p = find(handle, &layer);
+  if (p != NULL) {
+    release_layer(p, layer);
+    count_resident();
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void texture_streamer_free() {
+  if (!thread_started) {
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  for (int i = 0; i < TEXTURE_STREAMER_POOLS; i++) {
+    texture_pool* p = &pools[i];
+    for (int j = p->layer_count - 1; p->texture != 0 && j >= 0; j--) {
+      if (p->layers[j].handle != 0) {
+        release_layer(p, j);
+      }
+    }
+  }
+  count_resident();
+  quit = 1;
+  pthread_cond_broadcast(&work_ready);
+  pthread_mutex_unlock(&lock);
+
+  pthread_join(thread, NULL);
+  thread_started = 0;
+}
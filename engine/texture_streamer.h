@@ -0,0 +1,70 @@
+#ifndef texture_streamer_h
+#define texture_streamer_h
+
+#include "engine.h"
+
+#define TEXTURE_STREAMER_POOLS 128
+#define TEXTURE_STREAMER_LAYERS 32
+
+// levels this size and smaller are uploaded at load and never evicted
+#define TEXTURE_STREAMER_TAIL_SIZE 64
+
+// a baked texture living in one layer of a pool
+typedef struct {
+  GLuint handle;              // texture name given out by the loader, 0 if the layer is free
+  vfs_file baked;
+  const stex_header* header;
+} texture_layer;
+
+/* baked textures of the same format, size and mip count share one
+   GL_TEXTURE_2D_ARRAY, so meshes using any of them draw without rebinding.
+   the small mips of the chain go up at load, the finer ones are read from
+   the .stex files and uploaded for every layer when the renderer asks */
+typedef struct {
+  GLuint texture;
+  int format;
+  int width;
+  int height;
+  int level_count;
+  GLenum gl_format;
+
+  texture_layer layers[TEXTURE_STREAMER_LAYERS];
+  int layer_count;    // layers allocated in the array
+
+  int tail;           // first level that is always resident
+  int resident;       // finest uploaded level (GL_TEXTURE_BASE_LEVEL)
+  int wanted;         // finest level asked for since the last update
+  int loading;        // level being paged in, -1 if none
+  int ready;          // its pages are in memory
+  unsigned last_seen; // frame of the last request
+} texture_pool;
+
+// bytes of streamed levels allowed in video memory (the tails are not counted)
+extern long long texture_streamer_budget;
+
+// bytes of streamed levels resident or on their way
+extern long long texture_streamer_resident;
+
+// upload every level at load instead
+extern int texture_streamer_enabled;
+
+// adds the baked mip chain of 'handle' to its pool on the gl thread, the
+// streamer keeps the file open
+void texture_streamer_upload(GLuint handle, vfs_file* baked);
+
+// array texture and layer to sample for a handle, textures that are not
+// pooled are single layer arrays of their own
+GLuint texture_streamer_array(GLuint handle, int* layer);
+
+// the finest level that helps: 'uv_per_pixel' is how much of the texture's
+// 0..1 range one screen pixel covers where it is drawn
+void texture_streamer_request(GLuint handle, float uv_per_pixel);
+
+// once per frame: uploads the levels paged in, starts the next ones and
+// evicts the fine levels of pools not seen lately when over the budget
+void texture_streamer_update();
+
+void texture_streamer_remove(GLuint handle);
+void texture_streamer_free();
+
+#endif
@@ -0,0 +1,85 @@
+#include "vertex_table.h"
+
+static unsigned int hash(int v, int vt, int vn) {
+  unsigned int h = (unsigned int)v * 0x9e3779b1u;
+  h ^= (unsigned int)vt * 0x85ebca77u;
+  h ^= (unsigned int)vn * 0xc2b2ae3du;
+
+  // murmur3 finalizer
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+static vertex_table_entry* find(vertex_table_entry* entries, int capacity, int v, int vt, int vn) {
+  unsigned int mask = capacity - 1;
+  unsigned int i = hash(v, vt, vn) & mask;
+  while (entries[i].index >= 0 && (entries[i].v != v || entries[i].vt != vt || entries[i].vn != vn)) {
+    i = (i + 1) & mask;
+  }
+  return &entries[i];
+}
+
+static vertex_table_entry* alloc_entries(int capacity) {
+  vertex_table_entry* entries = malloc(capacity * sizeof(vertex_table_entry));
+  for (int i = 0; i < capacity; i++) {
+    entries[i].index = -1;
+  }
+  return entries;
+}
+
+vertex_table* vertex_table_new(int capacity) {
+  int c = 16;
+  while (c < capacity) c *= 2;
+
+  vertex_table* t = malloc(sizeof(vertex_table));
+  t->capacity = c;
+  t->size = 0;
+  t->first = 0;
+  t->entries = alloc_entries(c);
+  return t;
+}
+
+// returns the index stored for (v, vt, vn), or stores and returns index if the corner is new
+// (or was last seen in a previous mesh)
+int vertex_table_insert(vertex_table* t, int v, int vt, int vn, int index) {
+  vertex_table_entry* e = find(t->entries, t->capacity, v, vt, vn);
+  if (e->index >= t->first) {
+    return e->index;
+  }
+  if (e->index >= 0) {
+    e->index = index;
+    return index;
+  }
+
+  e->v = v;
+  e->vt = vt;
+  e->vn = vn;
+  e->index = index;
+  t->size++;
+
+  // keep load factor under 1/2
+  if (t->size * 2 > t->capacity) {
+    int new_capacity = t->capacity * 2;
+    vertex_table_entry* entries = alloc_entries(new_capacity);
+    for (int i = 0; i < t->capacity; i++) {
+      vertex_table_entry* old = &t->entries[i];
+      if (old->index >= 0) {
+        *find(entries, new_capacity, old->v, old->vt, old->vn) = *old;
+      }
+    }
+    free(t->entries);
+    t->entries = entries;
+    t->capacity = new_capacity;
+  }
+
+  return index;
+}
+
+void vertex_table_free(vertex_table* t) {
+  free(t->entries);
+  free(t);
+}
@@ -0,0 +1,26 @@
+#ifndef vertex_table_h
+#define vertex_table_h
+
+#include "engine.h"
+
+// one face corner (v/vt/vn, 0 when missing) and the vertex it was assigned
+typedef struct {
+  int v, vt, vn;
+  int index;
+} vertex_table_entry;
+
+// open addressing hash table, capacity is always a power of two
+typedef struct {
+  int capacity;
+  int size;
+  vertex_table_entry* entries;
+
+  // indices below this one belong to a previous mesh and are reassigned
+  int first;
+} vertex_table;
+
+vertex_table* vertex_table_new(int capacity);
+int vertex_table_insert(vertex_table* t, int v, int vt, int vn, int index);
+void vertex_table_free(vertex_table* t);
+
+#endif
@@ -0,0 +1,251 @@
+#include "vfs.h"
+#include "lz4.h"
+
+// mounted pack (read only once mounted, shared by the loader threads)
+static struct {
+  const char* data;
+  size_t size;
+  const pack_entry* entries;
+  int entry_count;
+  const char* names;
+} pack;
+
+unsigned long long vfs_hash(const char* data, size_t size) {
+  // fnv-1a
+  unsigned long long h = 1469598103934665603ULL;
+  for (size_t i = 0; i < size; i++) {
+    h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+static int map_file(const char* path, vfs_file* out) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return 0;
+  }
+
+  out->size = st.st_size;
+  out->data = NULL;
+  out->source = VFS_MAPPED;
+  if (out->size > 0) {
+    void* data = mmap(NULL, out->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return 0;
+    }
+    madvise(data, out->size, MADV_SEQUENTIAL);
+    out->data = data;
+  }
+
+  close(fd);
+  return 1;
+}
+
+// every range the header and the entries point at lies in the pack, and the
+// names block ends with a NUL, so no lookup or read can run off the mapping
+static int pack_valid(const char* data, size_t size) {
+  const pack_header* h = (const pack_header*)data;
+  if (memcmp(h->magic, "SPAK", 4) != 0 || h->version != VFS_PACK_VERSION) return 0;
+  if (h->entry_count < 0 || h->names_size < 0 || h->index_offset < (long long)sizeof(pack_header) || h->names_offset < 0) return 0;
+  if (h->index_offset + h->entry_count * (long long)sizeof(pack_entry) > (long long)size) return 0;
+  if (h->names_offset + h->names_size > (long long)size) return 0;
+  if (h->entry_count > 0 && (h->names_size == 0 || data[h->names_offset + h->names_size - 1] != '\0')) return 0;
+
+  const pack_entry* entries = (const pack_entry*)(data + h->index_offset);
+  for (int i = 0; i < h->entry_count; i++) {
+    const pack_entry* e = &entries[i];
+    if (e->offset < 0 || e->size < 0 || e->raw_size < 0 || e->offset > (long long)size - e->size) return 0;
+    if (e->name_offset < 0 || e->name_offset >= h->names_size) return 0;
+    // stored entries are used in place
+    if (!(e->flags & VFS_COMPRESSED) && e->raw_size != e->size) return 0;
+  }
+  return 1;
+}
+
+int vfs_mount(const char* pack_path) {
+  int fd = open(pack_path, O_RDONLY);
+  if (fd < 0) {
+    printf("[vfs] no pack at %s, using loose files\n", pack_path);
+    return 0;
+  }
+
+  struct stat st;
+  char* data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(pack_header)) {
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    printf("[vfs] cannot map %s, using loose files\n", pack_path);
+    return 0;
+  }
+
+  // entries are read on demand: no readahead past what is asked for,
+  // which would read neighbouring entries nobody uses
+  size_t size = st.st_size;
+  madvise(data, size, MADV_RANDOM);
+
+  const pack_header* h = (const pack_header*)data;
+  if (!pack_valid(data, size)) {
+    printf("[vfs] %s is not a pack or is corrupt, using loose files\n", pack_path);
+    munmap(data, size);
+    return 0;
+  }
+
+  vfs_unmount();
+  madvise(data, h->names_offset + h->names_size, MADV_WILLNEED);
+  pack.data = data;
+  pack.size = size;
+  pack.entries = (const pack_entry*)(data + h->index_offset);
+  pack.entry_count = h->entry_count;
+  pack.names = data + h->names_offset;
+
+  printf("[vfs] mounted %s (%d files)\n", pack_path, pack.entry_count);
+  return 1;
+}
+
+void vfs_unmount() {
+  if (pack.data != NULL) {
+    munmap((void*)pack.data, pack.size);
+  }
+  memset(&pack, 0, sizeof(pack));
+}
+
+static const pack_entry* find_entry(const char* path) {
+  unsigned long long h = vfs_hash(path, strlen(path));
+
+  // first entry with this hash
+  int lo = 0, hi = pack.entry_count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (pack.entries[mid].path_hash < h) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  for (int i = lo; i < pack.entry_count && pack.entries[i].path_hash == h; i++) {
+    if (strcmp(pack.names + pack.entries[i].name_offset, path) == 0) {
+      return &pack.entries[i];
+    }
+  }
+  return NULL;
+}
+
+int vfs_open(const char* path, vfs_file* out) {
+  const pack_entry* e = find_entry(path);
+  if (e == NULL) {
+    return map_file(path, out);
+  }
+
+  // read the whole entry at once
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t start = e->offset & ~(page - 1);
+  madvise((void*)(pack.data + start), e->offset + e->size - start, MADV_WILLNEED);
+
+  if (!(e->flags & VFS_COMPRESSED)) {
+    out->data = pack.data + e->offset;
+    out->size = e->raw_size;
+    out->source = VFS_PACKED;
+    return 1;
+  }
+
+  char* decoded = malloc(e->raw_size > 0 ? e->raw_size : 1);
+  if (lz4_decompress(pack.data + e->offset, e->size, decoded, e->raw_size) < 0) {
+    printf("[vfs] %s is corrupt in the pack\n", path);
+    free(decoded);
+    out->data = NULL;
+    return 0;
+  }
+  out->data = decoded;
+  out->size = e->raw_size;
+  out->source = VFS_DECODED;
+  return 1;
+}
+
+void vfs_close(vfs_file* f) {
+  if (f->data != NULL) {
+    switch (f->source) {
+      case VFS_PACKED:
+        break;
+      case VFS_MAPPED:
+        munmap((void*)f->data, f->size);
+        break;
+      case VFS_DECODED:
+        free((void*)f->data);
+        break;
+    }
+  }
+  f->data = NULL;
+  f->size = 0;
+}
+
+int vfs_stat(const char* path, long long* mtime, long long* size) {
+  const pack_entry* e = find_entry(path);
+  if (e != NULL) {
+    *mtime = e->mtime;
+    *size = e->raw_size;
+    return 1;
+  }
+
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return 0;
+  }
+  *mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+  *size = st.st_size;
+  return 1;
+}
+
+static int matches(const char* name, const char* ext) {
+  const char* dot = strrchr(name, '.');
+  return dot != NULL && dot != name && strcmp(dot + 1, ext) == 0;
+}
+
+static int compare_names(const void* a, const void* b) {
+  return strcmp(a, b);
+}
+
+int vfs_list(const char* dir, const char* ext, char names[][256], int max) {
+  int count = 0;
+  int in_pack = 0;
+  size_t len = strlen(dir);
+
+  for (int i = 0; i < pack.entry_count; i++) {
+    const char* path = pack.names + pack.entries[i].name_offset;
+    if (strncmp(path, dir, len) != 0 || strchr(path + len, '/') != NULL) continue;
+    in_pack = 1;
+    if (count < max && matches(path + len, ext)) {
+      strcpy(names[count++], path + len);
+    }
+  }
+
+  // directories that were not packed are read from disk
+  if (!in_pack) {
+    DIR* dr = opendir(dir);
+    if (dr == NULL) {
+      printf("[vfs] could not open directory: %s\n", dir);
+      return 0;
+    }
+
+    struct dirent* de;
+    while ((de = readdir(dr)) != NULL && count < max) {
+      if (matches(de->d_name, ext)) {
+        strcpy(names[count++], de->d_name);
+      }
+    }
+    closedir(dr);
+  }
+
+  // directory order is not stable
+  qsort(names, count, 256, compare_names);
+  return count;
+}
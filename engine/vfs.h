@@ -0,0 +1,60 @@
+#ifndef vfs_h
+#define vfs_h
+
+#include "engine.h"
+
+#define VFS_PACK_VERSION 1
+
+// pack entry flags
+#define VFS_COMPRESSED 1
+
+/* asset pack: header, the index sorted by path hash, the null terminated
+   paths, then 16 byte aligned data blobs. identical files share one blob */
+typedef struct {
+  char magic[4];
+  int version;
+  int entry_count;
+  int names_size;
+  long long index_offset;
+  long long names_offset;
+} pack_header;
+
+typedef struct {
+  unsigned long long path_hash;
+  long long offset;
+  long long size;       // bytes stored in the pack
+  long long raw_size;   // bytes once decompressed
+  long long mtime;      // of the packed file, keeps baked file stamps valid
+  int name_offset;
+  int flags;
+} pack_entry;
+
+typedef enum {
+  VFS_PACKED,   // points into the mounted pack
+  VFS_MAPPED,   // loose file mapping
+  VFS_DECODED   // decompressed copy
+} vfs_source;
+
+/* file contents, read only: packed files point into the pack mapping, where
+   deduplicated files share their bytes, and loose files are mapped read only.
+   copy what has to be edited */
+typedef struct {
+  const char* data;
+  size_t size;
+  vfs_source source;
+} vfs_file;
+
+unsigned long long vfs_hash(const char* data, size_t size);
+
+// files are read from the pack first, then from disk
+int vfs_mount(const char* pack_path);
+void vfs_unmount();
+
+int vfs_open(const char* path, vfs_file* out);
+void vfs_close(vfs_file* f);
+int vfs_stat(const char* path, long long* mtime, long long* size);
+
+// names of the files in 'dir' (ending with '/') with extension 'ext', sorted
+int vfs_list(const char* dir, const char* ext, char names[][256], int max);
+
+#endif
@@ -14,7 +14,6 @@ object blocks[(MAX_ROOM_SIZE + MAX_ROOM_SIZE) * 2];
 
 object* ground;
 object* roof;
-object* portal_model;
 
 static light portal_lights[NUM_PORTALS];
 static object* portal_models[NUM_PORTALS];
@@ -130,15 +129,15 @@ static void generate_portals() {
     l->color[2] = 1.0;
     l->cast_shadows = 1;
 
-    // portal model
+    // portal model (instances share the cached meshes and gpu buffers)
     float scale = 0.02f;
     // vec3 pos = { p->x / scale, 72, p->y / scale };
-    vec3 pos = { 0, 0, 0 };
-    portal_models[i] = object_create(pos, scale, portal_model->meshes, portal_model->num_meshes, 1, NULL);
+    portal_models[i] = asset_cache_instance("portal");
+    portal_models[i]->scale = scale;
+    vec3_zero(portal_models[i]->position);
 
     quat_identity(portal_models[i]->rotation);
     object_set_center(portal_models[i]);
-    renderer_init_object(portal_models[i]);
     portal_models[i]->receive_shadows = 1;
 
     // random rotation
@@ -172,9 +171,6 @@ static void generate_portals() {
 void dungeon_generate() {
   current_room = 0;
 
-  // portal model
-  portal_model = importer_load("portal");
-
   // init sample block
   material_init(&mat_stone);
   strcpy(mat_stone.name, "mat_stone");
@@ -246,7 +242,9 @@ void dungeon_generate() {
 }
 
 void dungeon_free() {
-  object_free(portal_model);
+  for (int i = 0; i < NUM_PORTALS; i++) {
+    asset_cache_release(portal_models[i]);
+  }
 
   renderer_free_object(ground);
   object_free(ground);
@@ -258,7 +256,7 @@ void dungeon_free() {
   object_free(block);
 
   for (int i = 0; i < NUM_PORTALS; i++) {
-    particle_generator_free(portal_pgs[i]);
     renderer_free_particle_generator(portal_pgs[i]);
+    particle_generator_free(portal_pgs[i]);
   }
 }
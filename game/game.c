@@ -45,6 +45,9 @@ void game_init(SDL_Window* window) {
   SDL_GetWindowSize(window, &width, &height);
   renderer_init(width, height);
 
+  // widest pose kernels the cpu has, for the animated objects
+  pose_kernels_init();
+
   // game camera
   game_camera.front[0] = 0.0f;
   game_camera.front[1] = 0.0f;
@@ -120,9 +123,17 @@ void game_init(SDL_Window* window) {
   mat_floor.reflectivity = 0;
   mat_floor.texture_subdivision = 300;
 
+  // load models on worker threads, the cache uploads them here once
+  const char* models[3] = { "mutant", "key", "portal" };
+  object* loaded[3];
+  importer_load_batch(models, loaded, 3);
+  for (int i = 0; i < 3; i++) {
+    asset_cache_add(models[i], loaded[i]);
+  }
+
   // load monster
   monster.state = MOVE;
-  monster.o = importer_load("mutant");
+  monster.o = asset_cache_instance("mutant");
   monster.o->scale = 0.015f;
   monster.o->receive_shadows = 0;
   physics_compute_aabb(monster.o);
@@ -132,15 +143,13 @@ void game_init(SDL_Window* window) {
   monster.dir[2] = 1;
   vec3_zero(monster.o->position);
   vec3_zero(target_pos);
-  renderer_init_object(monster.o);
   animator_play(monster.o, "walk", 1);
 
   monster.current_room = 0;
 
   // key
-  key = importer_load("key");
+  key = asset_cache_instance("key");
   object_set_center(key);
-  renderer_init_object(key);
   vec3 key_pos = { 20, 2, 10 };
   // vec3_scale(key_pos, key_pos, 1 / key->scale);
   vec3_copy(key->position, key_pos);
@@ -166,6 +175,10 @@ void game_init(SDL_Window* window) {
 
   // dungeon
   dungeon_generate();
+
+  // upload the textures the workers decoded meanwhile
+  texture_loader_finish();
+  texture_cache_report();
 }
 
 void game_resize(SDL_Window* window) {
@@ -188,8 +201,8 @@ void update_key() {
 }
 
 void update_monster() {
-  // update animation
-  animator_update(monster.o, delta_time);
+  // clock only, the pose is sampled when the frame is rendered
+  animator_advance(monster.o, delta_time);
 
   enum entity_state state = monster.state;
 
@@ -222,7 +235,7 @@ void update_monster() {
   vec3_sub(dist, scaled_pos, monster.o->position);
 
   if (vec3_len(dist) * monster.o->scale > 8) {
-    if (strcmp(monster.o->current_anim->name, "run") != 0)
+    if (strcmp(animator_current(monster.o), "run") != 0)
       animator_play(monster.o, "run", 1);
 
     // position
@@ -237,7 +250,7 @@ void update_monster() {
     float angle = vec3_angle_between(front, dir, y_axis);
     quat_rotate(monster.o->rotation, angle, y_axis);
   } else {
-    if (strcmp(monster.o->current_anim->name, "idle") != 0)
+    if (strcmp(animator_current(monster.o), "idle") != 0)
       animator_play(monster.o, "idle", 1);
     monster.state = IDLE;
   }
@@ -305,6 +318,11 @@ void game_render() {
   int width; int height;
   SDL_GetWindowSize(win, &width, &height);
 
+  // poses of the animated objects the camera and the shadow maps see
+  animator_view view;
+  renderer_animator_view(width, height, &game_camera, lights, NUM_PORTALS + 1, &view);
+  animator_schedule(game_render_list->objects, game_render_list->size, &view);
+
   renderer_render_objects(width, height, game_render_list->objects, game_render_list->size, NULL, 0, lights, NUM_PORTALS + 1, &game_camera, ui_render, &sky, pgs, NUM_PORTALS);
 }
 
@@ -314,11 +332,9 @@ void game_free() {
   // free dungeon
   dungeon_free();
 
-  //renderer_free_object(monster.o);
-  //object_free(monster.o);
-
-  renderer_free_object(key);
-  object_free(key);
+  asset_cache_release(monster.o);
+  asset_cache_release(key);
+  asset_cache_free();
 
   ui_free();
 
@@ -326,5 +342,8 @@ void game_free() {
 
   // cleanup engine modules
   audio_free();
+  texture_loader_free();
+  texture_cache_free();
+  texture_streamer_free();
   renderer_free();
 }
@@ -53,6 +53,9 @@ int main()
     return -1;
   }
 
+  // mount the asset pack (loose files are read when there is none)
+  vfs_mount("assets.pack");
+
   // init game
   game_init(window);
   while (running)
@@ -93,6 +96,7 @@ int main()
 
   // cleanup
   game_free();
+  vfs_unmount();
   SDL_GL_DeleteContext(context);
   SDL_DestroyWindow(window);
   SDL_Quit();
@@ -122,6 +122,11 @@ void ui_render() {
       renderer_shadow_pcf_enabled = renderer_shadow_pcf_enabled == 0 ? 1 : 0;
     }
 
+    nk_layout_row_static(ctx, 30, layout_width, 1);
+    if (nk_button_label(ctx, "Toggle animation lod")) {
+      animator_lod_enabled = animator_lod_enabled == 0 ? 1 : 0;
+    }
+
     char camera_pos[128];
     snprintf(camera_pos, 128, "camera: %.1f %.1f %.1f | %.1f %.1f %.1f\n", cam->pos[0], cam->pos[1], cam->pos[2], cam->front[0], cam->front[1], cam->front[2]);
     nk_label(ctx, camera_pos, NK_TEXT_LEFT);
@@ -129,6 +134,28 @@ void ui_render() {
     char ui_fps[256];
     snprintf(ui_fps, 256, "fps: %f\n", fps);
     nk_label(ctx, ui_fps, NK_TEXT_LEFT);
+
+    char ui_textures[128];
+    snprintf(ui_textures, 128, "streamed mips: %.1f / %.1f MB\n", texture_streamer_resident / 1048576.0, texture_streamer_budget / 1048576.0);
+    nk_label(ctx, ui_textures, NK_TEXT_LEFT);
+
+    char ui_binds[64];
+    snprintf(ui_binds, 64, "texture binds: %d\n", renderer_texture_binds);
+    nk_label(ctx, ui_binds, NK_TEXT_LEFT);
+
+    char ui_lods[128];
+    snprintf(ui_lods, 128, "lod triangles: %d / %d / %d / %d\n",
+      renderer_lod_triangles[0], renderer_lod_triangles[1], renderer_lod_triangles[2], renderer_lod_triangles[3]);
+    nk_label(ctx, ui_lods, NK_TEXT_LEFT);
+
+    char ui_shadow_lods[128];
+    snprintf(ui_shadow_lods, 128, "shadow lod triangles: %d / %d / %d / %d\n",
+      renderer_shadow_lod_triangles[0], renderer_shadow_lod_triangles[1], renderer_shadow_lod_triangles[2], renderer_shadow_lod_triangles[3]);
+    nk_label(ctx, ui_shadow_lods, NK_TEXT_LEFT);
+
+    char ui_skeletons[64];
+    snprintf(ui_skeletons, 64, "skeletons posed: %d / %d\n", animator_evaluated, animator_total);
+    nk_label(ctx, ui_skeletons, NK_TEXT_LEFT);
   }
   nk_end(ctx);
 
@@ -0,0 +1,478 @@
+#include "../engine/engine.h"
+#include "../engine/importer.h"
+
+// incremental asset build: mirrors assets/ into build/assets/, baking meshes
+// and converting textures on the way, and redoes a job only when the contents
+// of its sources or the version of its converter changed. make pack packs it
+// run from the game directory: cd game && ../tools/assets [-j jobs]
+
+#define ASSETS_MAX_JOBS 1024
+#define ASSETS_MAX_INPUTS 32
+#define ASSETS_MAX_THREADS 64
+#define ASSETS_MAX_PATH 256
+
+#define BUILD_PATH "build/"
+#define MANIFEST_PATH "build/manifest"
+
+// bump to redo every job of a converter
+#define COPY_VERSION 1
+#define TEXTURE_VERSION (1000 + STEX_VERSION)
+#define MESH_VERSION (IMPORTER_SMESH_VERSION * 1000 + IMPORTER_SANIM_VERSION)
+
+typedef enum {
+  JOB_COPY = 'c',     // copied as it is
+  JOB_TEXTURE = 't',  // copied, plus its block compressed mip chain in a .stex
+  JOB_MESH = 'm'      // obj, mtl, skl and anm of an asset baked to .smesh and .sanim
+} job_type;
+
+typedef struct {
+  job_type type;
+
+  // source path, or the asset directory for meshes
+  char key[ASSETS_MAX_PATH];
+  char inputs[ASSETS_MAX_INPUTS][ASSETS_MAX_PATH];
+  int input_count;
+
+  // names, mtimes and sizes of the inputs: unchanged means nothing to check
+  unsigned long long stamp;
+  // contents of the inputs: unchanged means nothing to redo
+  unsigned long long hash;
+  struct timespec mtime;
+
+  int converted;
+} build_job;
+
+typedef struct {
+  job_type type;
+  char key[ASSETS_MAX_PATH];
+  unsigned long long stamp;
+  unsigned long long hash;
+  int seen;
+} manifest_entry;
+
+static build_job jobs[ASSETS_MAX_JOBS];
+static int job_count = 0;
+
+static manifest_entry manifest[ASSETS_MAX_JOBS];
+static int manifest_count = 0;
+
+// jobs left to check, handed out to the workers in order
+static build_job* pending[ASSETS_MAX_JOBS];
+static int pending_count = 0;
+static int next_pending = 0;
+static pthread_mutex_t pending_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned long long mix(unsigned long long h, unsigned long long v) {
+  return (h ^ v) * 1099511628211ULL;
+}
+
+static int has_ext(const char* name, const char* ext) {
+  const char* dot = strrchr(name, '.');
+  return dot != NULL && strcasecmp(dot + 1, ext) == 0;
+}
+
+// images stb_image decodes, others are only copied
+static int is_texture(const char* name) {
+  const char* exts[] = { "png", "jpg", "jpeg", "bmp", "tga" };
+  for (int i = 0; i < 5; i++) {
+    if (has_ext(name, exts[i])) return 1;
+  }
+  return 0;
+}
+
+static int is_mesh_source(const char* name) {
+  return has_ext(name, "obj") || has_ext(name, "mtl") || has_ext(name, "skl") || has_ext(name, "anm");
+}
+
+static int file_exists(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0;
+}
+
+// creates every directory leading to path
+static void make_dirs(const char* path) {
+  char dir[512];
+  strcpy(dir, path);
+  for (char* p = dir + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      mkdir(dir, 0755);
+      *p = '/';
+    }
+  }
+}
+
+static build_job* add_job(job_type type, const char* key) {
+  if (job_count == ASSETS_MAX_JOBS) {
+    printf("[assets] more than %d jobs\n", ASSETS_MAX_JOBS);
+    exit(1);
+  }
+  build_job* job = &jobs[job_count++];
+  memset(job, 0, sizeof(build_job));
+  job->type = type;
+  strcpy(job->key, key);
+  return job;
+}
+
+static void add_input(build_job* job, const char* path) {
+  if (job->input_count == ASSETS_MAX_INPUTS) {
+    printf("[assets] %s has more than %d inputs\n", job->key, ASSETS_MAX_INPUTS);
+    exit(1);
+  }
+  strcpy(job->inputs[job->input_count++], path);
+}
+
+static void add_dir(const char* dir) {
+  DIR* dr = opendir(dir);
+  if (dr == NULL) {
+    printf("[assets] could not open directory: %s\n", dir);
+    exit(1);
+  }
+
+  // sources of the directory's mesh job
+  char mesh_inputs[ASSETS_MAX_INPUTS][ASSETS_MAX_PATH];
+  int mesh_input_count = 0;
+  int has_obj = 0;
+
+  struct dirent* de;
+  while ((de = readdir(dr)) != NULL) {
+    if (de->d_name[0] == '.') continue;
+    // baked next to the sources by make bake
+    if (has_ext(de->d_name, "smesh") || has_ext(de->d_name, "sanim") || has_ext(de->d_name, "stex")) continue;
+
+    // the path becomes a job key, manifest entry and mesh input, never cut short
+    char path[512];
+    int len = snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+    if (len < 0 || len >= ASSETS_MAX_PATH) {
+      printf("[assets] path longer than %d: %s/%s\n", ASSETS_MAX_PATH - 1, dir, de->d_name);
+      exit(1);
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) continue;
+    if (S_ISDIR(st.st_mode)) {
+      add_dir(path);
+      continue;
+    }
+    if (!S_ISREG(st.st_mode)) continue;
+
+    build_job* job = add_job(is_texture(path) ? JOB_TEXTURE : JOB_COPY, path);
+    add_input(job, path);
+
+    if (is_mesh_source(path)) {
+      // every source must reach the manifest, or editing it would not rebake
+      if (mesh_input_count == ASSETS_MAX_INPUTS) {
+        printf("[assets] %s has more than %d mesh sources\n", dir, ASSETS_MAX_INPUTS);
+        exit(1);
+      }
+      strcpy(mesh_inputs[mesh_input_count++], path);
+      has_obj |= has_ext(path, "obj");
+    }
+  }
+
+  closedir(dr);
+
+  // an asset directory with an obj is baked as a whole
+  if (has_obj) {
+    build_job* mesh = add_job(JOB_MESH, dir);
+    for (int i = 0; i < mesh_input_count; i++) {
+      add_input(mesh, mesh_inputs[i]);
+    }
+  }
+}
+
+static int version(job_type type) {
+  switch (type) {
+    case JOB_COPY: return COPY_VERSION;
+    case JOB_TEXTURE: return TEXTURE_VERSION;
+    case JOB_MESH: return MESH_VERSION;
+  }
+  return 0;
+}
+
+static void compute_stamp(build_job* job) {
+  unsigned long long h = mix(1469598103934665603ULL, job->type);
+  h = mix(h, version(job->type));
+  for (int i = 0; i < job->input_count; i++) {
+    struct stat st;
+    if (stat(job->inputs[i], &st) != 0) continue;
+    h = mix(h, vfs_hash(job->inputs[i], strlen(job->inputs[i])));
+    h = mix(h, st.st_mtim.tv_sec);
+    h = mix(h, st.st_mtim.tv_nsec);
+    h = mix(h, st.st_size);
+    if (i == 0) job->mtime = st.st_mtim;
+  }
+  job->stamp = h;
+}
+
+static void compute_hash(build_job* job) {
+  unsigned long long h = mix(1469598103934665603ULL, job->type);
+  h = mix(h, version(job->type));
+  for (int i = 0; i < job->input_count; i++) {
+    vfs_file file;
+    if (!vfs_open(job->inputs[i], &file)) {
+      printf("[assets] cannot read %s\n", job->inputs[i]);
+      exit(1);
+    }
+    h = mix(h, vfs_hash(job->inputs[i], strlen(job->inputs[i])));
+    h = mix(h, vfs_hash(file.data, file.size));
+    vfs_close(&file);
+  }
+  job->hash = h;
+}
+
+static void output_path(job_type type, const char* key, const char* ext, char* out) {
+  if (type == JOB_MESH) {
+    // build/assets/asset/asset.ext
+    const char* asset = strrchr(key, '/') + 1;
+    sprintf(out, "%s%s/%s.%s", BUILD_PATH, key, asset, ext);
+  } else {
+    sprintf(out, "%s%s", BUILD_PATH, key);
+  }
+}
+
+// build/assets/dir/name.stex next to the texture's copy
+static void baked_texture_path(const char* key, char* out) {
+  char copy[512];
+  output_path(JOB_TEXTURE, key, "", copy);
+  stex_path(copy, out);
+}
+
+static int outputs_exist(const build_job* job) {
+  char path[512];
+  output_path(job->type, job->key, "smesh", path);
+  if (!file_exists(path)) {
+    return 0;
+  }
+
+  if (job->type == JOB_TEXTURE) {
+    baked_texture_path(job->key, path);
+    return file_exists(path);
+  }
+
+  // skinned meshes also bake their skeleton and clips
+  for (int i = 0; job->type == JOB_MESH && i < job->input_count; i++) {
+    if (has_ext(job->inputs[i], "skl")) {
+      output_path(job->type, job->key, "sanim", path);
+      return file_exists(path);
+    }
+  }
+  return 1;
+}
+
+static void remove_outputs(job_type type, const char* key) {
+  char path[512];
+  output_path(type, key, "smesh", path);
+  unlink(path);
+  if (type == JOB_MESH) {
+    output_path(type, key, "sanim", path);
+    unlink(path);
+  }
+  if (type == JOB_TEXTURE) {
+    baked_texture_path(key, path);
+    unlink(path);
+  }
+}
+
+// copies the file keeping its mtime, baked files are stamped with their sources' mtimes
+static void copy_file(const build_job* job) {
+  char path[512];
+  output_path(job->type, job->key, "", path);
+  make_dirs(path);
+
+  vfs_file in;
+  if (!vfs_open(job->inputs[0], &in)) {
+    printf("[assets] cannot read %s\n", job->inputs[0]);
+    exit(1);
+  }
+
+  FILE* out = fopen(path, "wb");
+  if (out == NULL || fwrite(in.data, 1, in.size, out) != in.size) {
+    printf("[assets] cannot write %s\n", path);
+    exit(1);
+  }
+  fclose(out);
+  vfs_close(&in);
+
+  struct timespec times[2] = { job->mtime, job->mtime };
+  utimensat(AT_FDCWD, path, times, 0);
+}
+
+static void convert(build_job* job) {
+  switch (job->type) {
+    case JOB_COPY:
+      copy_file(job);
+      break;
+    case JOB_TEXTURE: {
+      // the copy is the fallback when the driver has no s3tc
+      copy_file(job);
+
+      char path[512];
+      baked_texture_path(job->key, path);
+      if (!stex_bake(job->inputs[0], path)) {
+        printf("[assets] cannot bake %s\n", job->key);
+        exit(1);
+      }
+      break;
+    }
+    case JOB_MESH: {
+      char dir[512];
+      sprintf(dir, "%s%s/", BUILD_PATH, job->key);
+      make_dirs(dir);
+
+      // key is assets/asset, the importer reads assets/ itself
+      char out_dir[512];
+      sprintf(out_dir, "%sassets/", BUILD_PATH);
+      if (!importer_bake(strrchr(job->key, '/') + 1, out_dir)) {
+        printf("[assets] cannot bake %s\n", job->key);
+        exit(1);
+      }
+      break;
+    }
+  }
+  job->converted = 1;
+}
+
+static manifest_entry* find_entry(job_type type, const char* key) {
+  for (int i = 0; i < manifest_count; i++) {
+    if (manifest[i].type == type && strcmp(manifest[i].key, key) == 0) {
+      return &manifest[i];
+    }
+  }
+  return NULL;
+}
+
+static void load_manifest() {
+  FILE* f = fopen(MANIFEST_PATH, "r");
+  if (f == NULL) {
+    return;
+  }
+
+  char line[512];
+  while (fgets(line, sizeof(line), f) && manifest_count < ASSETS_MAX_JOBS) {
+    manifest_entry* e = &manifest[manifest_count];
+    char type;
+    if (sscanf(line, "%c %llx %llx %255s", &type, &e->stamp, &e->hash, e->key) == 4) {
+      e->type = type;
+      e->seen = 0;
+      manifest_count++;
+    }
+  }
+
+  fclose(f);
+}
+
+static void save_manifest() {
+  FILE* f = fopen(MANIFEST_PATH ".tmp", "w");
+  if (f == NULL) {
+    printf("[assets] cannot write %s\n", MANIFEST_PATH);
+    exit(1);
+  }
+
+  for (int i = 0; i < job_count; i++) {
+    fprintf(f, "%c %016llx %016llx %s\n", jobs[i].type, jobs[i].stamp, jobs[i].hash, jobs[i].key);
+  }
+
+  fclose(f);
+  rename(MANIFEST_PATH ".tmp", MANIFEST_PATH);
+}
+
+static void* worker(void* arg) {
+  while (1) {
+    pthread_mutex_lock(&pending_lock);
+    build_job* job = next_pending < pending_count ? pending[next_pending++] : NULL;
+    pthread_mutex_unlock(&pending_lock);
+    if (job == NULL) break;
+
+    // touched but not edited: only the stamp changes
+    manifest_entry* e = find_entry(job->type, job->key);
+    compute_hash(job);
+    if (e == NULL || e->hash != job->hash || !outputs_exist(job)) {
+      convert(job);
+    }
+  }
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+    threads = atoi(argv[2]);
+  }
+  if (threads < 1) threads = 1;
+  if (threads > ASSETS_MAX_THREADS) threads = ASSETS_MAX_THREADS;
+
+  double start = now_ms();
+
+  mkdir(BUILD_PATH, 0755);
+  load_manifest();
+  add_dir("assets");
+
+  // unchanged stamps are up to date without reading anything
+  for (int i = 0; i < job_count; i++) {
+    build_job* job = &jobs[i];
+    compute_stamp(job);
+
+    manifest_entry* e = find_entry(job->type, job->key);
+    if (e != NULL) {
+      e->seen = 1;
+      if (e->stamp == job->stamp && outputs_exist(job)) {
+        job->hash = e->hash;
+        continue;
+      }
+    }
+    pending[pending_count++] = job;
+  }
+
+  // slowest jobs first so they do not end up last on one thread
+  for (int i = 0, m = 0; i < pending_count; i++) {
+    if (pending[i]->type == JOB_MESH) {
+      build_job* t = pending[m];
+      pending[m++] = pending[i];
+      pending[i] = t;
+    }
+  }
+
+  // independent jobs run in parallel
+  pthread_t workers[ASSETS_MAX_THREADS];
+  int worker_count = threads < pending_count ? threads : pending_count;
+  for (int i = 1; i < worker_count; i++) {
+    if (pthread_create(&workers[i], NULL, worker, NULL) != 0) {
+      printf("[assets] cannot create worker thread\n");
+      exit(1);
+    }
+  }
+  worker(NULL);
+  for (int i = 1; i < worker_count; i++) {
+    pthread_join(workers[i], NULL);
+  }
+
+  // sources that are gone
+  int removed = 0;
+  for (int i = 0; i < manifest_count; i++) {
+    if (!manifest[i].seen) {
+      remove_outputs(manifest[i].type, manifest[i].key);
+      removed++;
+    }
+  }
+
+  save_manifest();
+
+  int converted = 0;
+  for (int i = 0; i < job_count; i++) {
+    if (jobs[i].converted) {
+      printf("[assets] rebuilt %s\n", jobs[i].key);
+      converted++;
+    }
+  }
+
+  printf("[assets] %d jobs: %d rebuilt, %d checked, %d removed, %.1f ms (%d threads)\n",
+      job_count, converted, pending_count, removed, now_ms() - start, threads);
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "../engine/engine.h"
+#include "../engine/importer.h"
+#include "../engine/mesh_optimizer.h"
+
+// bakes obj assets to .smesh
+// run from the game directory: cd game && ../tools/bake [-o] [assets...]
+// without arguments every asset with an obj file is baked, -o also sorts
+// the triangles for less overdraw
+
+static int has_obj(const char* asset) {
+  char dir[512];
+  snprintf(dir, sizeof(dir), "assets/%s", asset);
+
+  DIR* dr = opendir(dir);
+  if (dr == NULL) {
+    return 0;
+  }
+
+  struct dirent* de;
+  int found = 0;
+  while ((de = readdir(dr)) != NULL) {
+    const char* dot = strrchr(de->d_name, '.');
+    if (dot && strcmp(dot + 1, "obj") == 0) {
+      found = 1;
+      break;
+    }
+  }
+
+  closedir(dr);
+  return found;
+}
+
+int main(int argc, char** argv) {
+  int failed = 0;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "-o") == 0) {
+    mesh_optimizer_overdraw = 1;
+    arg++;
+  }
+
+  if (argc > arg) {
+    for (int i = arg; i < argc; i++) {
+      failed += !importer_bake(argv[i], "assets/");
+    }
+    return failed > 0;
+  }
+
+  DIR* dr = opendir("assets");
+  if (dr == NULL) {
+    printf("[bake] run from the game directory\n");
+    return 1;
+  }
+
+  struct dirent* de;
+  while ((de = readdir(dr)) != NULL) {
+    if (de->d_name[0] != '.' && has_obj(de->d_name)) {
+      failed += !importer_bake(de->d_name, "assets/");
+    }
+  }
+
+  closedir(dr);
+  return failed > 0;
+}
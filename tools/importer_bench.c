@@ -0,0 +1,249 @@
+#include "../engine/engine.h"
+#include "../engine/importer.h"
+
+// importer load-time benchmark: the legacy obj loader, the tokenizer with
+// each thread count, and the baked files
+// run from the game directory: cd game && ../tools/importer_bench [runs] [threads...]
+
+#define BENCH_MAX_ASSETS 64
+#define BENCH_MAX_CONFIGS 8
+
+static double now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// reads a "Field:   123 kB" line from /proc/self/status
+static long status_kb(const char* field) {
+  FILE* f = fopen("/proc/self/status", "r");
+  if (f == NULL) {
+    return 0;
+  }
+
+  char line[256];
+  long kb = 0;
+  size_t len = strlen(field);
+  while (fgets(line, sizeof(line), f)) {
+    if (strncmp(line, field, len) == 0 && line[len] == ':') {
+      kb = atol(line + len + 1);
+      break;
+    }
+  }
+
+  fclose(f);
+  return kb;
+}
+
+// resets the VmHWM high water mark to the current rss
+static void reset_peak_rss() {
+  FILE* f = fopen("/proc/self/clear_refs", "w");
+  if (f != NULL) {
+    fputs("5", f);
+    fclose(f);
+  }
+}
+
+static int has_ext(const char* dir, const char* ext) {
+  DIR* dr = opendir(dir);
+  if (dr == NULL) {
+    return 0;
+  }
+
+  struct dirent* de;
+  int found = 0;
+  while ((de = readdir(dr)) != NULL) {
+    const char* dot = strrchr(de->d_name, '.');
+    if (dot && strcmp(dot + 1, ext) == 0) {
+      found = 1;
+      break;
+    }
+  }
+
+  closedir(dr);
+  return found;
+}
+
+static int find_assets(char assets[][256]) {
+  DIR* dr = opendir("assets");
+  if (dr == NULL) {
+    printf("[bench] run from the game directory\n");
+    exit(1);
+  }
+
+  int count = 0;
+  struct dirent* de;
+  while ((de = readdir(dr)) != NULL && count < BENCH_MAX_ASSETS) {
+    if (de->d_name[0] == '.') continue;
+
+    char dir[512];
+    snprintf(dir, sizeof(dir), "assets/%s", de->d_name);
+    if (has_ext(dir, "obj")) {
+      strcpy(assets[count++], de->d_name);
+    }
+  }
+
+  closedir(dr);
+  return count;
+}
+
+static double bench_asset(const char* asset, int runs, int* vertices, int* indices, long* peak_kb) {
+  double best = -1;
+  *peak_kb = 0;
+  for (int r = 0; r < runs; r++) {
+    reset_peak_rss();
+    long rss = status_kb("VmRSS");
+
+    double start = now_ms();
+    object* o = importer_load(asset);
+    double elapsed = now_ms() - start;
+
+    // memory touched by the load on top of what the process already used
+    long peak = status_kb("VmHWM") - rss;
+    if (peak > *peak_kb) *peak_kb = peak;
+
+    if (best < 0 || elapsed < best) best = elapsed;
+
+    *vertices = *indices = 0;
+    for (int i = 0; i < o->num_meshes; i++) {
+      *vertices += o->meshes[i].num_vertices;
+      *indices += o->meshes[i].num_indices;
+    }
+
+    object_free(o);
+    free(o);
+  }
+  return best;
+}
+
+// loads all assets concurrently, one thread per asset
+static double bench_batch(char assets[][256], int count, int runs) {
+  const char* names[IMPORTER_MAX_BATCH];
+  object* objects[IMPORTER_MAX_BATCH];
+  if (count > IMPORTER_MAX_BATCH) count = IMPORTER_MAX_BATCH;
+  for (int i = 0; i < count; i++) {
+    names[i] = assets[i];
+  }
+
+  double best = -1;
+  for (int r = 0; r < runs; r++) {
+    double start = now_ms();
+    importer_load_batch(names, objects, count);
+    double elapsed = now_ms() - start;
+
+    if (best < 0 || elapsed < best) best = elapsed;
+
+    for (int i = 0; i < count; i++) {
+      object_free(objects[i]);
+      free(objects[i]);
+    }
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  int runs = argc > 1 ? atoi(argv[1]) : 3;
+
+  // thread counts to compare (default: importer default)
+  int threads[BENCH_MAX_CONFIGS] = { 0 };
+  int config_count = 1;
+  if (argc > 2) {
+    config_count = 0;
+    for (int i = 2; i < argc && config_count < BENCH_MAX_CONFIGS; i++) {
+      threads[config_count++] = atoi(argv[i]);
+    }
+  }
+
+  char assets[BENCH_MAX_ASSETS][256];
+  int asset_count = find_assets(assets);
+
+  double legacy[BENCH_MAX_ASSETS];
+  double best[BENCH_MAX_CONFIGS][BENCH_MAX_ASSETS];
+  double baked[BENCH_MAX_ASSETS];
+  int vertices[BENCH_MAX_ASSETS];
+  int indices[BENCH_MAX_ASSETS];
+  long peak_kb[BENCH_MAX_ASSETS];
+
+  // the fgets/sscanf loader the tokenizer replaced
+  int legacy_vertices[BENCH_MAX_ASSETS];
+  int legacy_indices[BENCH_MAX_ASSETS];
+  long legacy_peak_kb;
+  importer_legacy = 1;
+  importer_threads = threads[0];
+  for (int i = 0; i < asset_count; i++) {
+    legacy[i] = bench_asset(assets[i], runs, &legacy_vertices[i], &legacy_indices[i], &legacy_peak_kb);
+  }
+  importer_legacy = 0;
+
+  // the tokenizer on the text files
+  importer_baked = 0;
+  for (int c = 0; c < config_count; c++) {
+    importer_threads = threads[c];
+    for (int i = 0; i < asset_count; i++) {
+      best[c][i] = bench_asset(assets[i], runs, &vertices[i], &indices[i], &peak_kb[i]);
+    }
+  }
+  importer_baked = 1;
+
+  // .smesh and .sanim files where they are fresh, text otherwise
+  int baked_vertices, baked_indices;
+  long baked_peak_kb;
+  importer_threads = threads[0];
+  for (int i = 0; i < asset_count; i++) {
+    baked[i] = bench_asset(assets[i], runs, &baked_vertices, &baked_indices, &baked_peak_kb);
+  }
+
+  // best time of each loader, speedup relative to the legacy one
+  // peak is the rss high water mark of the last thread count
+  printf("\n%-16s %10s %10s %10s %10s", "asset", "vertices", "indices", "peak MB", "legacy ms");
+  for (int c = 0; c < config_count; c++) {
+    char header[32];
+    snprintf(header, sizeof(header), "%dt ms", threads[c]);
+    printf(" %10s", header);
+  }
+  printf(" %10s\n", "baked ms");
+
+  double legacy_total = 0, baked_total = 0;
+  double total[BENCH_MAX_CONFIGS] = { 0 };
+  for (int i = 0; i < asset_count; i++) {
+    printf("%-16s %10d %10d %10.2f %10.2f", assets[i], vertices[i], indices[i], peak_kb[i] / 1024.0, legacy[i]);
+    legacy_total += legacy[i];
+    for (int c = 0; c < config_count; c++) {
+      printf(" %10.2f", best[c][i]);
+      total[c] += best[c][i];
+    }
+    printf(" %10.2f\n", baked[i]);
+    baked_total += baked[i];
+  }
+
+  printf("%-16s %10s %10s %10s %10.2f", "total", "", "", "", legacy_total);
+  for (int c = 0; c < config_count; c++) {
+    printf(" %10.2f", total[c]);
+  }
+  printf(" %10.2f\n%-16s %10s %10s %10s %9.2fx", baked_total, "speedup", "", "", "", 1.0);
+  for (int c = 0; c < config_count; c++) {
+    printf(" %9.2fx", legacy_total / total[c]);
+  }
+  printf(" %9.2fx\n", legacy_total / baked_total);
+
+  // both loaders should build the same meshes
+  for (int i = 0; i < asset_count; i++) {
+    if (legacy_vertices[i] != vertices[i] || legacy_indices[i] != indices[i]) {
+      printf("%s: legacy loader gives %d vertices, %d indices\n", assets[i], legacy_vertices[i], legacy_indices[i]);
+    }
+  }
+
+  // sequential total against a concurrent load of the same text files
+  importer_baked = 0;
+  importer_threads = threads[0];
+  int batch_count = asset_count < IMPORTER_MAX_BATCH ? asset_count : IMPORTER_MAX_BATCH;
+  double sequential = 0;
+  for (int i = 0; i < batch_count; i++) {
+    sequential += best[0][i];
+  }
+  double batch = bench_batch(assets, batch_count, runs);
+  printf("\nbatch of %d assets (%dt): %.2f ms sequential, %.2f ms concurrent, %.2fx\n",
+      batch_count, threads[0], sequential, batch, sequential / batch);
+
+  return 0;
+}
@@ -0,0 +1,221 @@
+#include "../engine/engine.h"
+
+// packs a directory into a single asset pack read through the vfs
+// run from the game directory: cd game && ../tools/pack [-z] assets.pack assets
+// -z stores entries lz4 compressed when that saves at least an eighth
+
+#define PACK_MAX_FILES 4096
+
+typedef struct {
+  char path[512];
+  char* data;
+  long long size;
+  long long mtime;
+  unsigned long long hash;
+
+  // first file with the same contents (itself if unique)
+  int blob;
+  long long offset;
+  long long stored;
+  int flags;
+} pack_file;
+
+static pack_file files[PACK_MAX_FILES];
+static int file_count = 0;
+
+static char* read_file(const char* path, long long size) {
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+
+  char* data = malloc(size > 0 ? size : 1);
+  if (fread(data, 1, size, f) != (size_t)size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+static void add_dir(const char* dir) {
+  DIR* dr = opendir(dir);
+  if (dr == NULL) {
+    printf("[pack] could not open directory: %s\n", dir);
+    exit(1);
+  }
+
+  struct dirent* de;
+  while ((de = readdir(dr)) != NULL) {
+    if (de->d_name[0] == '.') continue;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+
+    struct stat st;
+    if (stat(path, &st) != 0) continue;
+    if (S_ISDIR(st.st_mode)) {
+      add_dir(path);
+      continue;
+    }
+    if (!S_ISREG(st.st_mode)) continue;
+
+    if (file_count == PACK_MAX_FILES) {
+      printf("[pack] more than %d files\n", PACK_MAX_FILES);
+      exit(1);
+    }
+
+    pack_file* f = &files[file_count];
+    strcpy(f->path, path);
+    f->size = st.st_size;
+    f->mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    f->data = read_file(path, f->size);
+    if (f->data == NULL) {
+      printf("[pack] cannot read %s\n", path);
+      exit(1);
+    }
+    f->hash = vfs_hash(f->data, f->size);
+    file_count++;
+  }
+
+  closedir(dr);
+}
+
+static int compare_entries(const void* a, const void* b) {
+  const pack_entry* ea = a;
+  const pack_entry* eb = b;
+  if (ea->path_hash != eb->path_hash) {
+    return ea->path_hash < eb->path_hash ? -1 : 1;
+  }
+  return 0;
+}
+
+static long long align16(FILE* out, long long offset) {
+  char pad[16] = { 0 };
+  long long aligned = (offset + 15) & ~15LL;
+  fwrite(pad, 1, aligned - offset, out);
+  return aligned;
+}
+
+int main(int argc, char** argv) {
+  int compress = 0;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "-z") == 0) {
+    compress = 1;
+    arg++;
+  }
+  if (argc - arg != 2) {
+    printf("usage: pack [-z] out.pack dir\n");
+    return 1;
+  }
+  const char* out_path = argv[arg];
+  const char* dir = argv[arg + 1];
+
+  add_dir(dir);
+
+  FILE* out = fopen(out_path, "wb");
+  if (out == NULL) {
+    printf("[pack] cannot write %s\n", out_path);
+    return 1;
+  }
+
+  // header, index and paths come first so mounting reads a single range
+  int names_size = 0;
+  for (int i = 0; i < file_count; i++) {
+    names_size += strlen(files[i].path) + 1;
+  }
+
+  pack_header h;
+  memset(&h, 0, sizeof(h));
+  h.index_offset = sizeof(h);
+  h.names_offset = h.index_offset + (long long)file_count * sizeof(pack_entry);
+  long long offset = h.names_offset + names_size;
+  fseek(out, offset, SEEK_SET);
+
+  // blobs, identical files are stored once
+  long long loose_size = 0, deduped = 0, blob_count = 0;
+  for (int i = 0; i < file_count; i++) {
+    pack_file* f = &files[i];
+    loose_size += f->size;
+
+    f->blob = i;
+    for (int j = 0; j < i; j++) {
+      if (files[j].blob == j && files[j].hash == f->hash && files[j].size == f->size &&
+          memcmp(files[j].data, f->data, f->size) == 0) {
+        f->blob = j;
+        break;
+      }
+    }
+
+    if (f->blob != i) {
+      pack_file* b = &files[f->blob];
+      f->offset = b->offset;
+      f->stored = b->stored;
+      f->flags = b->flags;
+      deduped += f->size;
+      continue;
+    }
+
+    const char* data = f->data;
+    f->stored = f->size;
+    f->flags = 0;
+
+    char* packed = NULL;
+    if (compress && f->size > 0) {
+      int capacity = lz4_bound(f->size);
+      packed = malloc(capacity);
+      int packed_size = lz4_compress(f->data, f->size, packed, capacity);
+      if (packed_size > 0 && packed_size < f->size - f->size / 8) {
+        data = packed;
+        f->stored = packed_size;
+        f->flags = VFS_COMPRESSED;
+      }
+    }
+
+    offset = align16(out, offset);
+    f->offset = offset;
+    fwrite(data, 1, f->stored, out);
+    offset += f->stored;
+    blob_count++;
+    free(packed);
+  }
+
+  // index sorted by path hash, then the paths
+  pack_entry* entries = calloc(file_count, sizeof(pack_entry));
+  int name_offset = 0;
+  for (int i = 0; i < file_count; i++) {
+    pack_file* f = &files[i];
+    entries[i].path_hash = vfs_hash(f->path, strlen(f->path));
+    entries[i].offset = f->offset;
+    entries[i].size = f->stored;
+    entries[i].raw_size = f->size;
+    entries[i].mtime = f->mtime;
+    entries[i].name_offset = name_offset;
+    entries[i].flags = f->flags;
+    name_offset += strlen(f->path) + 1;
+  }
+  qsort(entries, file_count, sizeof(pack_entry), compare_entries);
+
+  memcpy(h.magic, "SPAK", 4);
+  h.version = VFS_PACK_VERSION;
+  h.entry_count = file_count;
+  h.names_size = names_size;
+  fseek(out, 0, SEEK_SET);
+  fwrite(&h, sizeof(h), 1, out);
+  fwrite(entries, sizeof(pack_entry), file_count, out);
+  for (int i = 0; i < file_count; i++) {
+    fwrite(files[i].path, 1, strlen(files[i].path) + 1, out);
+  }
+
+  int ok = ferror(out) == 0;
+  fclose(out);
+
+  printf("[pack] %s: %d files (%lld blobs), %.2f MB loose, %.2f MB deduplicated, %.2f MB packed\n",
+      out_path, file_count, blob_count, loose_size / 1048576.0, deduped / 1048576.0, offset / 1048576.0);
+
+  for (int i = 0; i < file_count; i++) {
+    free(files[i].data);
+  }
+  free(entries);
+  return !ok;
+}
@@ -0,0 +1,250 @@
+#include "../engine/engine.h"
+#include "../engine/data/skeleton.h"
+#include "../engine/data/animation.h"
+#include "../engine/pose_kernels.h"
+
+// animation benchmark: samples a clip and poses random skeletons of a few
+// sizes with the path the pose kernels replaced, then with every set of
+// kernels the cpu runs
+// usage: tools/skeleton_bench [poses per size]
+
+#define BENCH_SIZES 5
+#define BENCH_RUNS 5
+#define BENCH_KEYFRAMES 32
+#define BENCH_LEVELS 3
+
+static const int sizes[BENCH_SIZES] = { 8, 16, 32, 64, 127 };
+
+static double now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static float random_float(float min, float max) {
+  return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static void random_rotation(quat q) {
+  vec3 axis = { random_float(-1, 1), random_float(-1, 1), random_float(-1, 1) + 2.0f };
+  vec3_norm(axis, axis);
+  quat_rotate(q, random_float(-1.5f, 1.5f), axis);
+}
+
+// a random tree, every joint hangs off one of the joints before it
+static skeleton* random_skeleton(int joint_count) {
+  skeleton* s = skeleton_create();
+  frame* f = &s->rest_pose;
+  for (int i = 0; i < joint_count; i++) {
+    int parent = i == 0 ? -1 : rand() % i;
+    vec3 position = { random_float(-0.5f, 0.5f), random_float(0.0f, 1.0f), random_float(-0.5f, 0.5f) };
+    quat rotation;
+    random_rotation(rotation);
+    frame_joint_add(f, i, parent, position, rotation);
+  }
+  s->joint_count = joint_count;
+
+  // bind pose is the rest pose
+  frame_gen_transforms(f, NULL);
+  frame_gen_inv_transforms(f);
+  return s;
+}
+
+// a clip of random keyframes around the rest pose
+static animation* random_clip(skeleton* s) {
+  animation* a = animation_create("bench", s->joint_count);
+  frame* pose = malloc(sizeof(frame));
+  frame_copy_to(&s->rest_pose, pose);
+
+  for (int k = 0; k < BENCH_KEYFRAMES; k++) {
+    for (int j = 0; j < pose->joint_count; j++) {
+      vec3 position;
+      quat rotation;
+      frame_joint_get(&s->rest_pose, j, position, rotation);
+      random_rotation(rotation);
+      frame_joint_set(pose, j, position, rotation);
+    }
+    animation_add_keyframe(a, k, pose);
+  }
+  a->frame_count = a->keyframe_count;
+
+  free(pose);
+  return a;
+}
+
+/* the path the pose kernels replaced: a vec3 and a quat per joint, sampled
+   with vec3_lerp and quat_slerp, and a matrix per joint multiplied with its
+   parent's and the inverse bind one */
+typedef struct {
+  int joint_count;
+  int keyframe_count;
+  vec3* positions; // keyframe * joint_count + joint
+  quat* rotations;
+} baseline_clip;
+
+typedef struct {
+  vec3 positions[MAX_JOINTS];
+  quat rotations[MAX_JOINTS];
+  mat4 joint_transforms[MAX_JOINTS];
+  mat4 transforms[MAX_JOINTS];
+} baseline_pose;
+
+static baseline_clip baseline_clip_from(const animation* a) {
+  baseline_clip c;
+  c.joint_count = a->joint_count;
+  c.keyframe_count = a->frame_count;
+  c.positions = malloc((size_t)c.keyframe_count * c.joint_count * sizeof(vec3));
+  c.rotations = malloc((size_t)c.keyframe_count * c.joint_count * sizeof(quat));
+
+  for (int k = 0; k < c.keyframe_count; k++) {
+    const float* channels = animation_keyframe(a, k);
+    for (int j = 0; j < c.joint_count; j++) {
+      for (int i = 0; i < 3; i++) {
+        c.positions[k * c.joint_count + j][i] = channels[(POSE_X + i) * a->stride + j];
+      }
+      for (int i = 0; i < 4; i++) {
+        c.rotations[k * c.joint_count + j][i] = channels[(POSE_QX + i) * a->stride + j];
+      }
+    }
+  }
+  return c;
+}
+
+// a * b for matrices whose last row is 0 0 0 1, r must not be a or b
+static void affine_mul(mat4 r, const mat4 a, const mat4 b) {
+  for (int c = 0; c < 4; c++) {
+    for (int row = 0; row < 3; row++) {
+      r[c][row] = a[0][row] * b[c][0] + a[1][row] * b[c][1] + a[2][row] * b[c][2];
+    }
+    r[c][3] = 0.0f;
+  }
+  for (int row = 0; row < 3; row++) {
+    r[3][row] += a[3][row];
+  }
+  r[3][3] = 1.0f;
+}
+
+static void baseline_sample(const baseline_clip* c, const animation* a, float time, baseline_pose* out) {
+  float t = time / a->frame_speed;
+  int last = c->keyframe_count - 1;
+  int frame0 = (int)t < last ? (int)t : last;
+  int frame1 = (int)t + 1 < last ? (int)t + 1 : last;
+  float amount = fmod(t, 1.0);
+
+  for (int i = 0; i < c->joint_count; i++) {
+    vec3_lerp(out->positions[i], c->positions[frame0 * c->joint_count + i], c->positions[frame1 * c->joint_count + i], amount);
+    quat_slerp(out->rotations[i], c->rotations[frame0 * c->joint_count + i], c->rotations[frame1 * c->joint_count + i], amount);
+  }
+}
+
+static void baseline_transforms(baseline_pose* p, const frame* rest, int joint_count) {
+  for (int i = 0; i < joint_count; i++) {
+    int parent = rest->joint_parents[i];
+
+    mat4 local;
+    mat4_from_quat(local, p->rotations[i]);
+    local[3][0] = p->positions[i][0];
+    local[3][1] = p->positions[i][1];
+    local[3][2] = p->positions[i][2];
+    local[3][3] = 1.0f;
+
+    if (parent >= 0) {
+      affine_mul(p->joint_transforms[i], p->joint_transforms[parent], local);
+    } else {
+      mat4_copy(p->joint_transforms[i], local);
+    }
+    affine_mul(p->transforms[i], p->joint_transforms[i], rest->transforms_inv[i]);
+  }
+}
+
+// best time per pose of the baseline path, in us
+static double bench_baseline(const animation* a, const skeleton* s, int poses) {
+  baseline_clip c = baseline_clip_from(a);
+  baseline_pose* pose = malloc(sizeof(baseline_pose));
+
+  double best = -1;
+  for (int r = 0; r < BENCH_RUNS; r++) {
+    double start = now_ms();
+    for (int p = 0; p < poses; p++) {
+      float time = fmodf(p / 60.0f, a->frame_speed * (a->frame_count - 1));
+      baseline_sample(&c, a, time, pose);
+      baseline_transforms(pose, &s->rest_pose, s->joint_count);
+    }
+    double elapsed = now_ms() - start;
+    if (best < 0 || elapsed < best) best = elapsed;
+  }
+
+  free(pose);
+  free(c.positions);
+  free(c.rotations);
+  return best * 1000.0 / poses;
+}
+
+int main(int argc, char** argv) {
+  int poses = argc > 1 ? atoi(argv[1]) : 100000;
+  srand(1);
+
+  printf("%-8s %12s", "joints", "slerp us");
+  for (int l = 0; l < BENCH_LEVELS; l++) {
+    char header[32];
+    snprintf(header, sizeof(header), "%s us", pose_kernels_name(l));
+    printf(" %12s", header);
+  }
+  printf(" %12s %12s %12s\n", "ns/joint", "vs scalar", "vs slerp");
+
+  for (int i = 0; i < BENCH_SIZES; i++) {
+    skeleton* s = random_skeleton(sizes[i]);
+    animation* a = random_clip(s);
+    frame* pose = malloc(sizeof(frame));
+    frame_copy_to(&s->rest_pose, pose);
+
+    // transforms of the last pose of the scalar kernels, the others must match them
+    mat4* expected = malloc(pose->joint_count * sizeof(mat4));
+    double us[BENCH_LEVELS];
+    int mismatch = 0;
+
+    double slerp_us = bench_baseline(a, s, poses);
+    printf("%-8d %12.3f", sizes[i], slerp_us);
+    for (int l = 0; l < BENCH_LEVELS; l++) {
+      if (pose_kernels_select(l) != (pose_kernels_level)l) {
+        us[l] = -1;
+        printf(" %12s", "-");
+        continue;
+      }
+
+      double best = -1;
+      for (int r = 0; r < BENCH_RUNS; r++) {
+        double start = now_ms();
+        for (int p = 0; p < poses; p++) {
+          // a 60 hz clock running through the clip
+          float time = fmodf(p / 60.0f, a->frame_speed * (a->frame_count - 1));
+          animation_sample_to(a, time, pose);
+          frame_gen_transforms(pose, s->rest_pose.transforms_inv);
+        }
+        double elapsed = now_ms() - start;
+        if (best < 0 || elapsed < best) best = elapsed;
+      }
+
+      if (l == POSE_KERNELS_SCALAR) {
+        memcpy(expected, pose->transforms, pose->joint_count * sizeof(mat4));
+      } else if (memcmp(expected, pose->transforms, pose->joint_count * sizeof(mat4)) != 0) {
+        mismatch = 1;
+      }
+
+      us[l] = best * 1000.0 / poses;
+      printf(" %12.3f", us[l]);
+    }
+
+    // widest kernels against the scalar ones and the baseline
+    int widest = pose_kernels_select(POSE_KERNELS_AVX);
+    printf(" %12.2f %11.2fx %11.2fx%s\n", us[widest] * 1000.0 / sizes[i], us[0] / us[widest], slerp_us / us[widest],
+        mismatch ? "  (results differ)" : "");
+
+    free(expected);
+    free(pose);
+    animation_free(a);
+    skeleton_free(s);
+  }
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include "../engine/engine.h"
+#include "../engine/stex.h"
+
+// checks which texture names stex_bake takes for normal maps (bc5 keeps only
+// red and green, an albedo taken for one loses its colors)
+// usage: tools/stex_test
+
+typedef struct {
+  const char* path;
+  int normal_map;
+} name_case;
+
+static const name_case cases[] = {
+  { "assets/mutant/textures/parasiteZombie_normal.png", 1 },
+  { "assets/character/textures/Guard_03__normal.png", 1 },
+  { "assets/textures/stone/Stone_Wall_013_Normal.jpg", 1 },
+  { "assets/textures/Grass_001_NORM.jpg", 1 },
+  { "assets/textures/Grass_002_NRM.jpg", 1 },
+  { "assets/rock/textures/rock_4_nml_2.png", 1 },
+  { "assets/tree/textures/Pinetree_N.png", 1 },
+  { "normal.png", 1 },
+
+  // the tags inside other words
+  { "assets/textures/abnormal_wall.png", 0 },
+  { "assets/textures/enormous_door.png", 0 },
+  { "assets/textures/normandy_sign.png", 0 },
+  { "assets/textures/wall_nrml.png", 0 },
+  { "assets/textures/cnml_banner.png", 0 },
+  { "assets/textures/n.png", 0 },
+  { "assets/textures/wall_n2.png", 0 },
+  { "assets/norm_textures/wall.png", 0 },
+  { "assets/textures/wall.png", 0 },
+};
+
+int main() {
+  int count = sizeof(cases) / sizeof(cases[0]);
+  int failed = 0;
+  for (int i = 0; i < count; i++) {
+    int result = stex_is_normal_map(cases[i].path);
+    if (result != cases[i].normal_map) {
+      printf("[stex_test] %s: expected %s\n", cases[i].path, cases[i].normal_map ? "a normal map" : "not a normal map");
+      failed++;
+    }
+  }
+
+  printf("[stex_test] %d / %d names passed\n", count - failed, count);
+  return failed != 0;
+}